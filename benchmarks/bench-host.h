@@ -0,0 +1,494 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_BENCHMARKS_BENCH_HOST_H
+#define CONDUIT_BENCHMARKS_BENCH_HOST_H
+
+/*
+ * Just enough of a clap host to create our plugins in process and poke at them
+ * from a benchmark, plus the pieces to drive process() by hand: an input event
+ * list, an output sink, audio buffers shaped by the plugin's ports, a transport,
+ * a wav writer and a loop tying them together. No threads, no extensions, no gui.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <clap/clap.h>
+
+namespace sst::conduit::bench
+{
+struct BenchHost
+{
+    clap_host host{};
+
+    BenchHost()
+    {
+        host.clap_version = CLAP_VERSION;
+        host.host_data = this;
+        host.name = "Conduit Bench";
+        host.vendor = "Surge Synth Team";
+        host.url = "https://surge-synth-team.org";
+        host.version = "0.0.0";
+        host.get_extension = [](const clap_host *, const char *) -> const void * {
+            return nullptr;
+        };
+        host.request_restart = [](const clap_host *) {};
+        host.request_process = [](const clap_host *) {};
+        host.request_callback = [](const clap_host *) {};
+    }
+};
+
+// Creates and inits a plugin from our statically linked entry; destroys it on scope exit
+struct PluginInstance
+{
+    const clap_plugin *plugin{nullptr};
+
+    PluginInstance(const clap_host *host, const char *pluginId)
+    {
+        static bool entryInitialized{false};
+        if (!entryInitialized)
+        {
+            clap_entry.init("");
+            entryInitialized = true;
+        }
+
+        auto fac = static_cast<const clap_plugin_factory *>(
+            clap_entry.get_factory(CLAP_PLUGIN_FACTORY_ID));
+        if (!fac)
+            return;
+
+        plugin = fac->create_plugin(fac, host, pluginId);
+        if (plugin && !plugin->init(plugin))
+        {
+            plugin->destroy(plugin);
+            plugin = nullptr;
+        }
+    }
+    ~PluginInstance()
+    {
+        if (plugin)
+            plugin->destroy(plugin);
+    }
+    PluginInstance(const PluginInstance &) = delete;
+    PluginInstance &operator=(const PluginInstance &) = delete;
+
+    template <typename E> const E *extension(const char *id) const
+    {
+        return static_cast<const E *>(plugin->get_extension(plugin, id));
+    }
+};
+
+struct MemoryOStream
+{
+    std::vector<uint8_t> data;
+    clap_ostream stream{};
+
+    MemoryOStream()
+    {
+        stream.ctx = this;
+        stream.write = [](const clap_ostream *s, const void *buffer, uint64_t size) -> int64_t {
+            auto self = static_cast<MemoryOStream *>(s->ctx);
+            auto b = static_cast<const uint8_t *>(buffer);
+            self->data.insert(self->data.end(), b, b + size);
+            return (int64_t)size;
+        };
+    }
+};
+
+// Reads in host-sized pieces, like a DAW handing over a saved session would
+struct MemoryIStream
+{
+    const uint8_t *data{nullptr};
+    size_t size{0}, pos{0}, maxRead{1 << 16};
+    clap_istream stream{};
+
+    MemoryIStream(const void *d, size_t s) : data(static_cast<const uint8_t *>(d)), size(s)
+    {
+        stream.ctx = this;
+        stream.read = [](const clap_istream *s, void *buffer, uint64_t sz) -> int64_t {
+            auto self = static_cast<MemoryIStream *>(s->ctx);
+            auto n = std::min({(size_t)sz, self->size - self->pos, self->maxRead});
+            memcpy(buffer, self->data + self->pos, n);
+            self->pos += n;
+            return (int64_t)n;
+        };
+    }
+};
+
+// Median of repeated runs of f, in seconds
+template <typename F> double medianSeconds(int iterations, F &&f)
+{
+    std::vector<double> times;
+    times.reserve(iterations);
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto st = std::chrono::steady_clock::now();
+        f();
+        auto en = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double>(en - st).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// Percentile (0..1) of an unsorted set of samples, by sorting a copy
+inline double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    auto idx = std::min((size_t)(p * (double)(v.size() - 1) + 0.5), v.size() - 1);
+    return v[idx];
+}
+
+// The events for one process() call, in time order
+struct InputEvents
+{
+    union Event
+    {
+        clap_event_header_t header;
+        clap_event_note_t note;
+        clap_event_param_value_t param;
+        clap_event_param_mod_t paramMod;
+        clap_event_note_expression_t expression;
+        clap_event_midi_t midi;
+    };
+    std::vector<Event> events;
+    clap_input_events_t list{};
+
+    InputEvents()
+    {
+        events.reserve(1024);
+        list.ctx = this;
+        list.size = [](const clap_input_events_t *l) -> uint32_t {
+            return (uint32_t) static_cast<const InputEvents *>(l->ctx)->events.size();
+        };
+        list.get = [](const clap_input_events_t *l, uint32_t i) -> const clap_event_header_t * {
+            return &static_cast<const InputEvents *>(l->ctx)->events[i].header;
+        };
+    }
+
+    void clear() { events.clear(); }
+
+    void note(uint16_t type, uint32_t time, int16_t key, double velocity, int16_t channel = 0)
+    {
+        Event e;
+        e.note.header = {sizeof(clap_event_note_t), time, CLAP_CORE_EVENT_SPACE_ID, type, 0};
+        e.note.note_id = -1;
+        e.note.port_index = 0;
+        e.note.channel = channel;
+        e.note.key = key;
+        e.note.velocity = velocity;
+        events.push_back(e);
+    }
+
+    void param(uint32_t time, clap_id id, double value)
+    {
+        Event e;
+        e.param.header = {sizeof(clap_event_param_value_t), time, CLAP_CORE_EVENT_SPACE_ID,
+                          CLAP_EVENT_PARAM_VALUE, 0};
+        e.param.param_id = id;
+        e.param.cookie = nullptr;
+        e.param.note_id = -1;
+        e.param.port_index = -1;
+        e.param.channel = -1;
+        e.param.key = -1;
+        e.param.value = value;
+        events.push_back(e);
+    }
+
+    void paramMod(uint32_t time, clap_id id, double amount)
+    {
+        Event e;
+        e.paramMod.header = {sizeof(clap_event_param_mod_t), time, CLAP_CORE_EVENT_SPACE_ID,
+                             CLAP_EVENT_PARAM_MOD, 0};
+        e.paramMod.param_id = id;
+        e.paramMod.cookie = nullptr;
+        e.paramMod.note_id = -1;
+        e.paramMod.port_index = -1;
+        e.paramMod.channel = -1;
+        e.paramMod.key = -1;
+        e.paramMod.amount = amount;
+        events.push_back(e);
+    }
+
+    void noteExpression(uint32_t time, clap_note_expression id, int16_t key, int16_t channel,
+                        double value)
+    {
+        Event e;
+        e.expression.header = {sizeof(clap_event_note_expression_t), time,
+                               CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_NOTE_EXPRESSION, 0};
+        e.expression.expression_id = id;
+        e.expression.note_id = -1;
+        e.expression.port_index = 0;
+        e.expression.channel = channel;
+        e.expression.key = key;
+        e.expression.value = value;
+        events.push_back(e);
+    }
+
+    void midi(uint32_t time, uint8_t b0, uint8_t b1, uint8_t b2)
+    {
+        Event e;
+        e.midi.header = {sizeof(clap_event_midi_t), time, CLAP_CORE_EVENT_SPACE_ID,
+                         CLAP_EVENT_MIDI, 0};
+        e.midi.port_index = 0;
+        e.midi.data[0] = b0;
+        e.midi.data[1] = b1;
+        e.midi.data[2] = b2;
+        events.push_back(e);
+    }
+};
+
+// Takes whatever the plugin sends and just counts it
+struct OutputEvents
+{
+    uint64_t count{0};
+    clap_output_events_t list{};
+
+    OutputEvents()
+    {
+        list.ctx = this;
+        list.try_push = [](const clap_output_events_t *l, const clap_event_header_t *) {
+            static_cast<OutputEvents *>(l->ctx)->count++;
+            return true;
+        };
+    }
+};
+
+/*
+ * One set of channel buffers per audio port, sized from the plugin's audio ports
+ * extension, and the clap_audio_buffer arrays pointing at them.
+ */
+struct AudioBuffers
+{
+    std::vector<std::vector<std::vector<float>>> storage[2];
+    std::vector<std::vector<float *>> pointers[2];
+    std::vector<clap_audio_buffer_t> buffers[2];
+
+    void configure(const PluginInstance &inst, uint32_t maxFrames)
+    {
+        auto ap = inst.extension<clap_plugin_audio_ports>(CLAP_EXT_AUDIO_PORTS);
+        for (int dir = 0; dir < 2; ++dir)
+        {
+            auto isInput = dir == 0;
+            auto n = ap ? ap->count(inst.plugin, isInput) : 0;
+            storage[dir].assign(n, {});
+            pointers[dir].assign(n, {});
+            buffers[dir].assign(n, {});
+            for (auto p = 0U; p < n; ++p)
+            {
+                clap_audio_port_info_t info{};
+                ap->get(inst.plugin, p, isInput, &info);
+                storage[dir][p].assign(info.channel_count, std::vector<float>(maxFrames, 0.f));
+                for (auto &c : storage[dir][p])
+                    pointers[dir][p].push_back(c.data());
+                buffers[dir][p].data32 = pointers[dir][p].data();
+                buffers[dir][p].channel_count = info.channel_count;
+            }
+        }
+    }
+
+    std::vector<std::vector<float>> &inputs(uint32_t port) { return storage[0][port]; }
+    std::vector<std::vector<float>> &outputs(uint32_t port) { return storage[1][port]; }
+    uint32_t inputPorts() const { return (uint32_t)buffers[0].size(); }
+    uint32_t outputPorts() const { return (uint32_t)buffers[1].size(); }
+
+    void attachTo(clap_process_t &p)
+    {
+        p.audio_inputs = buffers[0].empty() ? nullptr : buffers[0].data();
+        p.audio_inputs_count = inputPorts();
+        p.audio_outputs = buffers[1].empty() ? nullptr : buffers[1].data();
+        p.audio_outputs_count = outputPorts();
+    }
+};
+
+// A playing 4/4 transport at a fixed tempo, advanced block by block
+struct Transport
+{
+    clap_event_transport_t ev{};
+    double tempo{120};
+
+    Transport()
+    {
+        ev.header = {sizeof(clap_event_transport_t), 0, CLAP_CORE_EVENT_SPACE_ID,
+                     CLAP_EVENT_TRANSPORT, 0};
+        ev.flags = CLAP_TRANSPORT_HAS_TEMPO | CLAP_TRANSPORT_HAS_BEATS_TIMELINE |
+                   CLAP_TRANSPORT_HAS_TIME_SIGNATURE | CLAP_TRANSPORT_IS_PLAYING;
+        ev.tempo = tempo;
+        ev.tsig_num = 4;
+        ev.tsig_denom = 4;
+    }
+
+    void setTempo(double t)
+    {
+        tempo = t;
+        ev.tempo = t;
+    }
+
+    void setPosition(double seconds)
+    {
+        auto beats = seconds * tempo / 60.0;
+        ev.song_pos_beats = (clap_beattime)(beats * CLAP_BEATTIME_FACTOR);
+        ev.song_pos_seconds = (clap_sectime)(seconds * CLAP_SECTIME_FACTOR);
+        ev.bar_number = (int32_t)(beats / 4);
+        ev.bar_start = (clap_beattime)(ev.bar_number * 4.0 * CLAP_BEATTIME_FACTOR);
+    }
+};
+
+// Interleaved 32 bit float wav, with the sizes patched in on close
+struct WavWriter
+{
+    FILE *f{nullptr};
+    uint16_t channels{0};
+    uint32_t frames{0};
+
+    bool open(const std::string &path, uint16_t nChannels, uint32_t sampleRate)
+    {
+        f = fopen(path.c_str(), "wb");
+        if (!f)
+            return false;
+        channels = nChannels;
+
+        auto u32 = [this](uint32_t v) { fwrite(&v, 4, 1, f); };
+        auto u16 = [this](uint16_t v) { fwrite(&v, 2, 1, f); };
+        fwrite("RIFF", 1, 4, f);
+        u32(0);
+        fwrite("WAVEfmt ", 1, 8, f);
+        u32(16);
+        u16(3); // IEEE float
+        u16(channels);
+        u32(sampleRate);
+        u32(sampleRate * channels * 4);
+        u16((uint16_t)(channels * 4));
+        u16(32);
+        fwrite("data", 1, 4, f);
+        u32(0);
+        return true;
+    }
+
+    void write(const std::vector<std::vector<float>> &chans, uint32_t n)
+    {
+        if (!f)
+            return;
+        for (auto i = 0U; i < n; ++i)
+            for (auto c = 0U; c < channels; ++c)
+                fwrite(&chans[c][i], 4, 1, f);
+        frames += n;
+    }
+
+    void close()
+    {
+        if (!f)
+            return;
+        uint32_t dataBytes = frames * channels * 4;
+        uint32_t riffBytes = dataBytes + 36;
+        fseek(f, 4, SEEK_SET);
+        fwrite(&riffBytes, 4, 1, f);
+        fseek(f, 40, SEEK_SET);
+        fwrite(&dataBytes, 4, 1, f);
+        fclose(f);
+        f = nullptr;
+    }
+    ~WavWriter() { close(); }
+};
+
+/*
+ * One activated plugin and everything its process() calls need. Fill inEvents
+ * and the input buffers, then processBlock() runs a block, advances the transport
+ * and clears the events.
+ */
+struct ProcessLoop
+{
+    BenchHost host;
+    PluginInstance inst;
+    AudioBuffers audio;
+    InputEvents inEvents;
+    OutputEvents outEvents;
+    Transport transport;
+    clap_process_t process{};
+    double sampleRate{48000};
+    uint32_t blockSize{256};
+    uint64_t framePos{0};
+    bool active{false};
+
+    explicit ProcessLoop(const char *pluginId) : inst(&host.host, pluginId) {}
+
+    bool activate(double sr, uint32_t bs)
+    {
+        if (!inst.plugin)
+            return false;
+        sampleRate = sr;
+        blockSize = bs;
+        audio.configure(inst, blockSize);
+        process.frames_count = blockSize;
+        process.transport = &transport.ev;
+        process.in_events = &inEvents.list;
+        process.out_events = &outEvents.list;
+        audio.attachTo(process);
+
+        active = inst.plugin->activate(inst.plugin, sampleRate, 1, blockSize);
+        if (active && !inst.plugin->start_processing(inst.plugin))
+        {
+            inst.plugin->deactivate(inst.plugin);
+            active = false;
+        }
+        return active;
+    }
+
+    // Seconds spent in process(), or a negative number if it returned an error
+    double processBlock()
+    {
+        transport.setPosition(framePos / sampleRate);
+        process.steady_time = (int64_t)framePos;
+
+        auto st = std::chrono::steady_clock::now();
+        auto status = inst.plugin->process(inst.plugin, &process);
+        auto en = std::chrono::steady_clock::now();
+
+        inEvents.clear();
+        framePos += blockSize;
+        if (status == CLAP_PROCESS_ERROR)
+            return -1;
+        return std::chrono::duration<double>(en - st).count();
+    }
+
+    void deactivate()
+    {
+        if (active)
+        {
+            inst.plugin->stop_processing(inst.plugin);
+            inst.plugin->deactivate(inst.plugin);
+            active = false;
+        }
+    }
+
+    ~ProcessLoop() { deactivate(); }
+};
+} // namespace sst::conduit::bench
+
+#endif // CONDUIT_BENCHMARKS_BENCH_HOST_H
@@ -0,0 +1,557 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * conduit-bench renders any of our plugins with no DAW and no audio device. It
+ * feeds a note and param script (a built-in chord pattern by default), a test
+ * signal on any audio inputs and a playing transport through process() at the
+ * block size and sample rate you ask for, then reports the realtime factor and
+ * the distribution of per-block times. Optionally it writes the first output port
+ * to a wav.
+ *
+ * usage: conduit-bench [options]
+ *   --list                 list the plugin ids and exit
+ *   --plugin ID            plugin id, or its last part (default polysynth)
+ *   --sr HZ                sample rate (default 48000)
+ *   --block N              block size (default 256)
+ *   --seconds S            length to render (default 10)
+ *   --script FILE          events, one per line, replacing the built-in pattern:
+ *                            <seconds> on <key> <velocity>
+ *                            <seconds> off <key>
+ *                            <seconds> param <id> <value>
+ *   --param ID=VALUE       set a param at time 0 (repeatable)
+ *   --input silence|saw    signal for audio inputs (default saw)
+ *   --wav FILE             write the first output port as 32 bit float
+ *   --stress               run the stress scenarios instead, --seconds each, and
+ *                          report the tail of the block times
+ *   --scenario NAME        only that stress scenario: chords, param-mod, mpe-bend,
+ *                          patch-load or tempo
+ *
+ * Script files can have # comments.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "bench-host.h"
+#include "plugin-access.h"
+
+namespace cb = sst::conduit::bench;
+
+struct ScriptEvent
+{
+    double time{0};
+    enum Kind
+    {
+        NOTE_ON,
+        NOTE_OFF,
+        PARAM
+    } kind{NOTE_ON};
+    int16_t key{60};
+    clap_id id{0};
+    double value{0};
+};
+
+// Three note chords on every half second, each held a little under that, walking the keyboard
+std::vector<ScriptEvent> defaultScript(double seconds)
+{
+    std::vector<ScriptEvent> res;
+    static constexpr int roots[] = {48, 53, 55, 50, 57, 52, 60, 45};
+    int step{0};
+    for (double t = 0; t < seconds; t += 0.5, ++step)
+    {
+        auto root = roots[step % 8] + 12 * ((step / 8) % 2);
+        for (auto iv : {0, 4, 7})
+        {
+            res.push_back({t, ScriptEvent::NOTE_ON, (int16_t)(root + iv), 0, 0.8});
+            res.push_back({t + 0.4, ScriptEvent::NOTE_OFF, (int16_t)(root + iv), 0, 0});
+        }
+    }
+    return res;
+}
+
+bool readScript(const std::string &path, std::vector<ScriptEvent> &res)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        fprintf(stderr, "Unable to open script '%s'\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    int lineNo{0};
+    while (std::getline(in, line))
+    {
+        lineNo++;
+        if (auto h = line.find('#'); h != std::string::npos)
+            line = line.substr(0, h);
+
+        std::istringstream ls(line);
+        ScriptEvent e;
+        std::string kind;
+        if (!(ls >> e.time >> kind))
+            continue;
+
+        bool ok{false};
+        if (kind == "on")
+        {
+            e.kind = ScriptEvent::NOTE_ON;
+            ok = (bool)(ls >> e.key >> e.value);
+        }
+        else if (kind == "off")
+        {
+            e.kind = ScriptEvent::NOTE_OFF;
+            ok = (bool)(ls >> e.key);
+        }
+        else if (kind == "param")
+        {
+            e.kind = ScriptEvent::PARAM;
+            ok = (bool)(ls >> e.id >> e.value);
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "%s:%d: can't parse '%s'\n", path.c_str(), lineNo, line.c_str());
+            return false;
+        }
+        res.push_back(e);
+    }
+    return true;
+}
+
+std::string resolvePluginId(const std::string &arg)
+{
+    auto fac = static_cast<const clap_plugin_factory *>(
+        clap_entry.get_factory(CLAP_PLUGIN_FACTORY_ID));
+    for (auto i = 0U; fac && i < fac->get_plugin_count(fac); ++i)
+    {
+        std::string id = fac->get_plugin_descriptor(fac, i)->id;
+        if (id == arg || (id.size() > arg.size() && id.substr(id.size() - arg.size()) == arg &&
+                          id[id.size() - arg.size() - 1] == '.'))
+            return id;
+    }
+    return {};
+}
+
+// A quiet saw with a little noise, the same into every input channel
+struct TestSignal
+{
+    bool silent{false};
+    double phase{0}, dPhase{0};
+    uint32_t noise{22222};
+
+    TestSignal(double sampleRate, bool silent) : silent(silent), dPhase(110.0 / sampleRate) {}
+
+    void fill(cb::ProcessLoop &loop)
+    {
+        for (auto i = 0U; i < loop.blockSize; ++i)
+        {
+            float v{0};
+            if (!silent)
+            {
+                noise = noise * 1664525 + 1013904223;
+                v = (float)(0.25 * (2 * phase - 1) + 0.02 * ((noise >> 8) / 8388608.0 - 1));
+                phase += dPhase;
+                if (phase >= 1)
+                    phase -= 1;
+            }
+            for (auto p = 0U; p < loop.audio.inputPorts(); ++p)
+                for (auto &c : loop.audio.inputs(p))
+                    c[i] = v;
+        }
+    }
+};
+
+void printBlockTimes(const char *label, const std::vector<double> &t, double budget)
+{
+    auto over = std::count_if(t.begin(), t.end(), [budget](auto v) { return v > budget; });
+    printf("%-10s p50 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us  over budget %zu/%zu\n", label,
+           cb::percentile(t, 0.5) * 1e6, cb::percentile(t, 0.99) * 1e6,
+           cb::percentile(t, 0.999) * 1e6, cb::percentile(t, 1.0) * 1e6, (size_t)over, t.size());
+}
+
+/*
+ * Stress mode. Average throughput hides the blocks which actually drop out, so
+ * each scenario here is built to provoke the worst block a plugin has and we
+ * report the tail. Every scenario runs on a fresh instance with the test signal
+ * on its inputs; the ones that don't apply to a plugin (notes into an effect,
+ * say) just cost it nothing.
+ */
+struct StressContext
+{
+    cb::ProcessLoop &loop;
+    std::vector<clap_id> modulatable;
+    std::filesystem::path patch;
+    std::minstd_rand rng{1234};
+};
+
+void holdNotes(StressContext &c, int n)
+{
+    for (int i = 0; i < n; ++i)
+        c.loop.inEvents.note(CLAP_EVENT_NOTE_ON, 0, (int16_t)(48 + i), 0.8);
+}
+
+// 64 notes on one sample, held a few blocks, then all released on one sample
+void stressChords(StressContext &c, uint64_t b)
+{
+    if (b % 8 != 0 && b % 8 != 4)
+        return;
+    uint16_t type = b % 8 == 0 ? CLAP_EVENT_NOTE_ON : CLAP_EVENT_NOTE_OFF;
+    for (int16_t k = 30; k < 30 + 64; ++k)
+        c.loop.inEvents.note(type, 0, k, 0.9);
+}
+
+// A param mod on every modulatable param on every sample
+void stressParamMod(StressContext &c, uint64_t b)
+{
+    if (b == 0)
+        holdNotes(c, 8);
+    for (auto s = 0U; s < c.loop.blockSize; ++s)
+    {
+        auto ph = 2 * M_PI * (c.loop.framePos + s) / 4800.0;
+        for (auto i = 0U; i < c.modulatable.size(); ++i)
+            c.loop.inEvents.paramMod(s, c.modulatable[i], 0.25 * std::sin(ph + i));
+    }
+}
+
+// An MPE style note per channel and a pitch bend on every sample, as midi and as tuning
+void stressMPEBend(StressContext &c, uint64_t b)
+{
+    if (b == 0)
+        for (int16_t ch = 1; ch < 16; ++ch)
+            c.loop.inEvents.note(CLAP_EVENT_NOTE_ON, 0, (int16_t)(50 + ch), 0.8, ch);
+
+    for (auto s = 0U; s < c.loop.blockSize; ++s)
+    {
+        auto pos = c.loop.framePos + s;
+        auto ch = (int16_t)(1 + pos % 15);
+        auto bend = std::sin(2 * M_PI * pos / 2400.0);
+        auto v14 = (int)((bend + 1) * 8191.5);
+        c.loop.inEvents.midi(s, (uint8_t)(0xE0 | ch), v14 & 0x7F, (v14 >> 7) & 0x7F);
+        c.loop.inEvents.noteExpression(s, CLAP_NOTE_EXPRESSION_TUNING, (int16_t)(50 + ch), ch,
+                                       bend * 2);
+    }
+}
+
+// Patch loads queued the way the editor does, so the worker parses and the audio thread swaps
+void stressPatchLoad(StressContext &c, uint64_t b)
+{
+    if (b == 0)
+        holdNotes(c, 8);
+    if (b % 16 == 8)
+        cb::requestPatchLoad(c.loop.inst, c.patch);
+}
+
+// A new tempo every block, which among other things retimes the delay taps
+void stressTempo(StressContext &c, uint64_t b)
+{
+    if (b == 0)
+        holdNotes(c, 8);
+    c.loop.transport.setTempo(std::uniform_real_distribution<double>(40, 300)(c.rng));
+}
+
+static constexpr struct
+{
+    const char *name;
+    void (*events)(StressContext &, uint64_t);
+} stressScenarios[] = {{"chords", stressChords},
+                       {"param-mod", stressParamMod},
+                       {"mpe-bend", stressMPEBend},
+                       {"patch-load", stressPatchLoad},
+                       {"tempo", stressTempo}};
+
+int runStress(const std::string &pluginId, double sampleRate, uint32_t blockSize,
+              double seconds, bool silent, const std::string &only)
+{
+    if (!only.empty() && std::none_of(std::begin(stressScenarios), std::end(stressScenarios),
+                                      [&only](const auto &sc) { return only == sc.name; }))
+    {
+        fprintf(stderr, "No stress scenario called '%s'\n", only.c_str());
+        return 1;
+    }
+
+    auto patch = std::filesystem::temp_directory_path() /
+                 ("conduit-bench-stress-" +
+                  std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                  ".patch");
+    auto nBlocks = (uint64_t)(seconds * sampleRate / blockSize) + 1;
+    auto budget = blockSize / sampleRate;
+
+    printf("plugin     %s\n", pluginId.c_str());
+    printf("stress     %.2f s per scenario at %.0f Hz, %u sample blocks (budget %.1f us)\n",
+           seconds, sampleRate, blockSize, budget * 1e6);
+
+    for (const auto &sc : stressScenarios)
+    {
+        if (!only.empty() && only != sc.name)
+            continue;
+
+        cb::ProcessLoop loop(pluginId.c_str());
+        if (!loop.activate(sampleRate, blockSize))
+        {
+            fprintf(stderr, "Unable to activate '%s'\n", pluginId.c_str());
+            return 1;
+        }
+
+        StressContext ctx{loop, {}, patch};
+        if (auto params = loop.inst.extension<clap_plugin_params>(CLAP_EXT_PARAMS))
+        {
+            for (auto i = 0U; i < params->count(loop.inst.plugin); ++i)
+            {
+                clap_param_info info;
+                if (params->get_info(loop.inst.plugin, i, &info) &&
+                    (info.flags & CLAP_PARAM_IS_MODULATABLE))
+                    ctx.modulatable.push_back(info.id);
+            }
+        }
+
+        // The patch we keep loading is the instance's own default state
+        if (sc.events == stressPatchLoad)
+        {
+            auto state = loop.inst.extension<clap_plugin_state>(CLAP_EXT_STATE);
+            cb::MemoryOStream os;
+            std::ofstream out(patch, std::ios::binary);
+            if (!state || !state->save(loop.inst.plugin, &os.stream) || !out.is_open())
+            {
+                printf("%-10s skipped, unable to write a patch to load\n", sc.name);
+                continue;
+            }
+            out.write((const char *)os.data.data(), os.data.size());
+        }
+
+        TestSignal signal(sampleRate, silent);
+        std::vector<double> times;
+        times.reserve(nBlocks);
+        for (uint64_t b = 0; b < nBlocks; ++b)
+        {
+            sc.events(ctx, b);
+            signal.fill(loop);
+            auto t = loop.processBlock();
+            if (t < 0)
+            {
+                fprintf(stderr, "process() returned an error in '%s'\n", sc.name);
+                return 1;
+            }
+            times.push_back(t);
+        }
+        printBlockTimes(sc.name, times, budget);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(patch, ec);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string pluginArg{"polysynth"}, scriptPath, wavPath, input{"saw"}, stressOnly;
+    double sampleRate{48000}, seconds{10};
+    uint32_t blockSize{256};
+    bool stress{false};
+    std::vector<std::pair<clap_id, double>> initialParams;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "%s needs a value\n", a.c_str());
+                exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (a == "--list")
+        {
+            auto fac = static_cast<const clap_plugin_factory *>(
+                clap_entry.get_factory(CLAP_PLUGIN_FACTORY_ID));
+            for (auto p = 0U; p < fac->get_plugin_count(fac); ++p)
+                printf("%s\n", fac->get_plugin_descriptor(fac, p)->id);
+            return 0;
+        }
+        else if (a == "--plugin")
+            pluginArg = next();
+        else if (a == "--sr")
+            sampleRate = std::atof(next().c_str());
+        else if (a == "--block")
+            blockSize = (uint32_t)std::atoi(next().c_str());
+        else if (a == "--seconds")
+            seconds = std::atof(next().c_str());
+        else if (a == "--script")
+            scriptPath = next();
+        else if (a == "--wav")
+            wavPath = next();
+        else if (a == "--input")
+            input = next();
+        else if (a == "--stress")
+            stress = true;
+        else if (a == "--scenario")
+            stressOnly = next();
+        else if (a == "--param")
+        {
+            auto pv = next();
+            auto eq = pv.find('=');
+            if (eq == std::string::npos)
+            {
+                fprintf(stderr, "--param wants ID=VALUE, not '%s'\n", pv.c_str());
+                return 1;
+            }
+            initialParams.emplace_back((clap_id)std::stoul(pv.substr(0, eq)),
+                                       std::atof(pv.substr(eq + 1).c_str()));
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument '%s'; see the top of conduit-bench.cpp\n",
+                    a.c_str());
+            return 1;
+        }
+    }
+
+    if (sampleRate <= 0 || blockSize == 0 || seconds <= 0)
+    {
+        fprintf(stderr, "Sample rate, block size and length must all be positive\n");
+        return 1;
+    }
+
+    auto pluginId = resolvePluginId(pluginArg);
+    if (pluginId.empty())
+    {
+        fprintf(stderr, "No plugin matches '%s'; try --list\n", pluginArg.c_str());
+        return 1;
+    }
+
+    if (stress)
+        return runStress(pluginId, sampleRate, blockSize, seconds, input == "silence",
+                         stressOnly);
+
+    std::vector<ScriptEvent> script;
+    if (scriptPath.empty())
+        script = defaultScript(seconds);
+    else if (!readScript(scriptPath, script))
+        return 1;
+    for (auto &[id, v] : initialParams)
+        script.push_back({0, ScriptEvent::PARAM, 0, id, v});
+    std::stable_sort(script.begin(), script.end(),
+                     [](const auto &a, const auto &b) { return a.time < b.time; });
+
+    cb::ProcessLoop loop(pluginId.c_str());
+    if (!loop.activate(sampleRate, blockSize))
+    {
+        fprintf(stderr, "Unable to create and activate '%s'\n", pluginId.c_str());
+        return 1;
+    }
+
+    cb::WavWriter wav;
+    if (!wavPath.empty())
+    {
+        if (loop.audio.outputPorts() == 0)
+        {
+            fprintf(stderr, "'%s' has no audio outputs to write\n", pluginId.c_str());
+            return 1;
+        }
+        if (!wav.open(wavPath, (uint16_t)loop.audio.outputs(0).size(), (uint32_t)sampleRate))
+        {
+            fprintf(stderr, "Unable to open '%s'\n", wavPath.c_str());
+            return 1;
+        }
+    }
+
+    auto totalFrames = (uint64_t)(seconds * sampleRate);
+    auto nBlocks = (totalFrames + blockSize - 1) / blockSize;
+    std::vector<double> blockTimes;
+    blockTimes.reserve(nBlocks);
+
+    size_t nextEvent{0};
+    TestSignal signal(sampleRate, input == "silence");
+
+    for (uint64_t b = 0; b < nBlocks; ++b)
+    {
+        auto blockStart = b * blockSize;
+
+        while (nextEvent < script.size() &&
+               (uint64_t)(script[nextEvent].time * sampleRate) < blockStart + blockSize)
+        {
+            const auto &e = script[nextEvent++];
+            auto t = (uint32_t)std::max((int64_t)(e.time * sampleRate) - (int64_t)blockStart,
+                                        (int64_t)0);
+            switch (e.kind)
+            {
+            case ScriptEvent::NOTE_ON:
+                loop.inEvents.note(CLAP_EVENT_NOTE_ON, t, e.key, e.value);
+                break;
+            case ScriptEvent::NOTE_OFF:
+                loop.inEvents.note(CLAP_EVENT_NOTE_OFF, t, e.key, 0);
+                break;
+            case ScriptEvent::PARAM:
+                loop.inEvents.param(t, e.id, e.value);
+                break;
+            }
+        }
+
+        signal.fill(loop);
+
+        auto t = loop.processBlock();
+        if (t < 0)
+        {
+            fprintf(stderr, "process() returned an error at block %llu\n", (unsigned long long)b);
+            return 1;
+        }
+        blockTimes.push_back(t);
+
+        if (wav.f)
+        {
+            auto n = (uint32_t)std::min((uint64_t)blockSize, totalFrames - blockStart);
+            wav.write(loop.audio.outputs(0), n);
+        }
+    }
+    wav.close();
+
+    double wall{0};
+    for (auto t : blockTimes)
+        wall += t;
+    auto budget = blockSize / sampleRate;
+
+    printf("plugin    %s\n", pluginId.c_str());
+    printf("render    %.2f s at %.0f Hz, %u sample blocks (%llu blocks)\n", seconds, sampleRate,
+           blockSize, (unsigned long long)nBlocks);
+    printf("wall      %.4f s, realtime factor %.1fx\n", wall, (nBlocks * budget) / wall);
+    printf("block us  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f  (budget %.1f)\n",
+           cb::percentile(blockTimes, 0.5) * 1e6, cb::percentile(blockTimes, 0.9) * 1e6,
+           cb::percentile(blockTimes, 0.99) * 1e6, cb::percentile(blockTimes, 1.0) * 1e6,
+           budget * 1e6);
+    printf("events    %zu in, %llu out\n", script.size(),
+           (unsigned long long)loop.outEvents.count);
+    if (!wavPath.empty())
+        printf("wav       %s\n", wavPath.c_str());
+    return 0;
+}
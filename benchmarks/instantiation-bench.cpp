@@ -0,0 +1,179 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * Times how long our plugins take to come and go, which is what a host pays
+ * scanning plugins or loading a project with dozens of instances. For each plugin
+ * it reports the very first create (which also builds the process wide tables),
+ * then the median and worst of create + init and of destroy over many instances,
+ * and finally a create, activate, deactivate and destroy cycle, so what was
+ * deferred to activate shows up somewhere.
+ *
+ * usage: conduit-instantiation-bench [options]
+ *   --plugin ID            only this plugin id, or its last part
+ *   --iterations N         instances per measurement (default 200)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "bench-host.h"
+
+namespace cb = sst::conduit::bench;
+
+using clock_type = std::chrono::steady_clock;
+
+double since(clock_type::time_point st)
+{
+    return std::chrono::duration<double>(clock_type::now() - st).count();
+}
+
+struct Timings
+{
+    double first{0};
+    std::vector<double> create, destroy, cycle;
+};
+
+bool measure(const clap_plugin_factory *fac, const clap_host *host, const char *id,
+             int iterations, Timings &t)
+{
+    auto make = [&]() -> const clap_plugin * {
+        auto p = fac->create_plugin(fac, host, id);
+        if (p && !p->init(p))
+        {
+            p->destroy(p);
+            p = nullptr;
+        }
+        return p;
+    };
+
+    auto st = clock_type::now();
+    auto p = make();
+    t.first = since(st);
+    if (!p)
+        return false;
+    p->destroy(p);
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        st = clock_type::now();
+        p = make();
+        t.create.push_back(since(st));
+        if (!p)
+            return false;
+
+        st = clock_type::now();
+        p->destroy(p);
+        t.destroy.push_back(since(st));
+    }
+
+    // Activation is far heavier for some plugins, so fewer of these
+    for (int i = 0; i < std::max(iterations / 10, 1); ++i)
+    {
+        st = clock_type::now();
+        p = make();
+        if (!p || !p->activate(p, 48000, 1, 512))
+            return false;
+        p->deactivate(p);
+        p->destroy(p);
+        t.cycle.push_back(since(st));
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string only;
+    int iterations{200};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "%s needs a value\n", a.c_str());
+                exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (a == "--plugin")
+            only = next();
+        else if (a == "--iterations")
+            iterations = std::max(std::atoi(next().c_str()), 1);
+        else
+        {
+            fprintf(stderr, "Unknown argument '%s'; see the top of instantiation-bench.cpp\n",
+                    a.c_str());
+            return 1;
+        }
+    }
+
+    cb::BenchHost host;
+    clap_entry.init("");
+    auto fac = static_cast<const clap_plugin_factory *>(
+        clap_entry.get_factory(CLAP_PLUGIN_FACTORY_ID));
+    if (!fac)
+    {
+        fprintf(stderr, "No plugin factory\n");
+        return 1;
+    }
+
+    printf("%-48s %10s %10s %10s %10s %10s %12s\n", "plugin", "first us", "create us",
+           "worst us", "destroy us", "worst us", "activate us");
+
+    int matched{0};
+    for (auto i = 0U; i < fac->get_plugin_count(fac); ++i)
+    {
+        std::string id = fac->get_plugin_descriptor(fac, i)->id;
+        if (!only.empty() && id != only &&
+            !(id.size() > only.size() && id.substr(id.size() - only.size()) == only &&
+              id[id.size() - only.size() - 1] == '.'))
+            continue;
+        matched++;
+
+        Timings t;
+        if (!measure(fac, &host.host, id.c_str(), iterations, t))
+        {
+            fprintf(stderr, "Unable to create and activate '%s'\n", id.c_str());
+            return 1;
+        }
+        printf("%-48s %10.1f %10.1f %10.1f %10.1f %10.1f %12.1f\n", id.c_str(), t.first * 1e6,
+               cb::percentile(t.create, 0.5) * 1e6, cb::percentile(t.create, 1.0) * 1e6,
+               cb::percentile(t.destroy, 0.5) * 1e6, cb::percentile(t.destroy, 1.0) * 1e6,
+               cb::percentile(t.cycle, 0.5) * 1e6);
+    }
+
+    clap_entry.deinit();
+    if (!matched)
+    {
+        fprintf(stderr, "No plugin matches '%s'\n", only.c_str());
+        return 1;
+    }
+    return 0;
+}
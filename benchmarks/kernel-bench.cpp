@@ -0,0 +1,615 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * Times the hot loops Conduit owns on its own, each against a plain scalar
+ * reference of the same maths, so a vectorised or specialised rewrite can show
+ * both that it still computes the same thing and how much faster it is:
+ *
+ *   - the polysynth SVF step, in every mode
+ *   - the polysynth unison saw bank at full unison, per unison voice sample
+ *   - the polysynth voice group's filter routing loop (LPF, waveshaper and SVF in
+ *     each order, two stereo voices a register), per voice sample
+ *   - the ring modulator's diode bridge
+ *   - the polymetric delay's tap loop, checked by where each tap's impulse lands
+ *   - the polymetric delay's dry level ramp, checked to hold until its event
+ *
+ * The loops with AVX2 variants (the same kernels compiled with AVX2 and FMA enabled)
+ * run the one this machine picks, which is printed first; CONDUIT_SIMD=baseline in
+ * the environment times the SSE2 build instead.
+ *
+ * Exits non zero if any kernel is out of tolerance.
+ *
+ * usage: conduit-kernel-bench [iterations]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "bench-host.h"
+#include "plugin-access.h"
+#include "conduit-shared/cpu-dispatch.h"
+
+namespace cb = sst::conduit::bench;
+using sst::conduit::polymetric_delay::ConduitPolymetricDelay;
+using sst::conduit::polysynth::ConduitPolysynth;
+using sst::conduit::polysynth::PolysynthVoice;
+using SVF = PolysynthVoice::StereoSimperSVF;
+
+static constexpr double sampleRate{48000};
+static int iterations{200};
+static bool allPassed{true};
+static volatile float sink{0};
+
+void report(const std::string &name, double nsPerSample, double maxErr, double tolerance)
+{
+    auto ok = maxErr <= tolerance;
+    allPassed = allPassed && ok;
+    printf("%-28s %10.3f ns/sample   max err %9.2e (tol %7.1e) %s\n", name.c_str(), nsPerSample,
+           maxErr, tolerance, ok ? "ok" : "FAIL");
+}
+
+// A saw, a detuned saw and some noise; different on each side
+std::vector<float> testSignal(size_t n, int seed)
+{
+    std::vector<float> res(n);
+    std::minstd_rand gen(seed);
+    std::uniform_real_distribution<float> urd(-1.f, 1.f);
+    double p0{0}, p1{0};
+    for (auto &r : res)
+    {
+        p0 += 131.0 / sampleRate;
+        p1 += (131.0 + seed) / sampleRate;
+        p0 -= std::floor(p0);
+        p1 -= std::floor(p1);
+        r = (float)(0.3 * (2 * p0 - 1) + 0.2 * (2 * p1 - 1) + 0.05 * urd(gen));
+    }
+    return res;
+}
+
+float lane(__m128 v, int i)
+{
+    float r alignas(16)[4];
+    _mm_store_ps(r, v);
+    return r[i];
+}
+
+/*
+ * The Simper SVF in double, one channel, written out from the comments in
+ * stepSSE. It takes g and k from one lane of a configured SVF so this checks the
+ * step and not fasttan.
+ */
+struct ReferenceSVF
+{
+    double k, a1, a2, a3, ak, ic1eq{0}, ic2eq{0};
+
+    explicit ReferenceSVF(const SVF &s, int l = 0)
+    {
+        auto g = (double)lane(s.g, l);
+        k = lane(s.k, l);
+        a1 = 1.0 / (1.0 + g * (g + k));
+        a2 = g * a1;
+        a3 = g * a2;
+        ak = (g + k) * a1;
+        ic1eq = lane(s.ic1eq, l);
+        ic2eq = lane(s.ic2eq, l);
+    }
+
+    double step(int mode, double vin)
+    {
+        auto v3 = vin - ic2eq;
+        auto v0 = a1 * v3 - ak * ic1eq;
+        auto v1 = a2 * v3 + a1 * ic1eq;
+        auto v2 = a3 * v3 + a2 * ic1eq + ic2eq;
+        ic1eq = 2 * v1 - ic1eq;
+        ic2eq = 2 * v2 - ic2eq;
+
+        switch (mode)
+        {
+        case SVF::LP:
+            return v2;
+        case SVF::BP:
+            return v1;
+        case SVF::HP:
+            return v0;
+        case SVF::NOTCH:
+            return v2 + v0;
+        case SVF::PEAK:
+            return v2 - v0;
+        case SVF::ALL:
+            return v2 + v0 - k * v1;
+        }
+        return 0;
+    }
+};
+
+template <int Mode> void benchSVF(const char *name)
+{
+    static constexpr size_t n{4096};
+    auto inL = testSignal(n, 1), inR = testSignal(n, 2);
+
+    SVF svf;
+    svf.init();
+    svf.setCoeff(72, 0.6, 1.0 / sampleRate);
+
+    ReferenceSVF refL(svf), refR(svf);
+    double maxErr{0};
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto out = SVF::stepSSE<Mode>(svf, _mm_set_ps(0, 0, inR[i], inL[i]));
+        maxErr = std::max(maxErr, std::fabs(lane(out, 0) - refL.step(Mode, inL[i])));
+        maxErr = std::max(maxErr, std::fabs(lane(out, 1) - refR.step(Mode, inR[i])));
+    }
+
+    auto t = cb::medianSeconds(iterations, [&]() {
+        svf.init();
+        auto acc = _mm_setzero_ps();
+        for (size_t i = 0; i < n; ++i)
+            acc = _mm_add_ps(acc, SVF::stepSSE<Mode>(svf, _mm_set_ps(0, 0, inR[i], inL[i])));
+        sink = lane(acc, 0);
+    });
+
+    report(std::string("svf ") + name, t * 1e9 / n, maxErr, 1e-4);
+}
+
+/*
+ * The bank at full unison against each saw run on its own: the same float phase and
+ * glide, since that is what the bank keeps, with the output and the pan sum in double.
+ * The first block jumps to a chord of frequencies and the second glides away from it,
+ * over the voice's glide length and then holding for the rest of the block.
+ */
+void benchSawBank()
+{
+    static constexpr int nUni{PolysynthVoice::max_uni}, bs{PolysynthVoice::blockSizeOS};
+    static constexpr int glide{PolysynthVoice::blockSize}, nBlocks{512};
+    using Bank = sst::conduit::polysynth::UnisonSawBank<nUni, glide>;
+
+    float hz[2][nUni], gainL[nUni], gainR[nUni];
+    for (int i = 0; i < nUni; ++i)
+    {
+        hz[0][i] = 110.f * std::pow(2.f, (i - nUni / 2) / 24.f);
+        hz[1][i] = 1.5f * hz[0][i];
+        gainL[i] = std::cos(0.1f * i) / 4;
+        gainR[i] = std::sin(0.1f * i) / 4;
+    }
+    const auto srInv = (float)(1.0 / sampleRate);
+
+    auto bank = std::make_unique<Bank>();
+    bank->retrigger(nUni);
+    bank->setGains(gainL, gainR);
+
+    float phase[nUni]{}, dPhase[nUni], dPhaseStep[nUni]{};
+    double maxErr{0};
+    for (int b = 0; b < nBlocks; ++b)
+    {
+        auto &f = hz[b > 0];
+        if (b < 2)
+        {
+            bank->setFrequencies(f, srInv);
+            for (int i = 0; i < nUni; ++i)
+            {
+                auto target = std::clamp(f[i] * srInv, 1e-7f, 0.49f);
+                if (b == 0)
+                    dPhase[i] = target;
+                else
+                    dPhaseStep[i] = (target - dPhase[i]) * (1.f / glide);
+            }
+        }
+
+        for (int s = 0; s < bs; ++s)
+        {
+            double refL{0}, refR{0};
+            for (int i = 0; i < nUni; ++i)
+            {
+                float q = phase[i], p = q + (dPhase[i] + dPhase[i]);
+                if (p > 1.f)
+                    p -= 2.f;
+                auto out = ((double)p * p - (double)q * q) / (4.0 * dPhase[i]);
+                refL += gainL[i] * out;
+                refR += gainR[i] * out;
+                phase[i] = p;
+                if (b == 1 && s < glide)
+                    dPhase[i] += dPhaseStep[i];
+            }
+
+            float L, R;
+            bank->step(L, R);
+            maxErr = std::max({maxErr, std::fabs(L - refL), std::fabs(R - refR)});
+        }
+    }
+
+    auto t = cb::medianSeconds(iterations, [&]() {
+        float acc{0};
+        for (int b = 0; b < nBlocks; ++b)
+        {
+            bank->setFrequencies(hz[b & 1], srInv);
+            for (int s = 0; s < bs; ++s)
+            {
+                float L, R;
+                bank->step(L, R);
+                acc += L + R;
+            }
+        }
+        sink = acc;
+    });
+    report("unison saw bank", t * 1e9 / (nBlocks * bs * nUni), maxErr, 1e-4);
+}
+
+/*
+ * The routing loop runs in a real voice group holding two voices started against a
+ * real synth, so the filters and waveshaper are set up as they are in a patch, and
+ * each of the four lanes gets its own signal. The reference is the same chain written
+ * sample by sample: the reference SVF in double per lane, and copies of the group's LPF
+ * and waveshaper state run through the same function pointers. That copy is why this
+ * uses a non comb LPF, since the comb state points into the group's delay buffers.
+ */
+void benchRouting(ConduitPolysynth &synth)
+{
+    using sst::conduit::polysynth::VoiceGroup;
+    using lipol_t = decltype(PolysynthVoice::wsDrive_lipol);
+    static constexpr const char *names[] = {"Low>WS>Multi", "Multi>WS>Low", "WS>Low>Multi",
+                                            "Low>Multi>WS", "WS>Par",       "Par>WS"};
+    static constexpr size_t nBlocks{256}, os{PolysynthVoice::blockSizeOS};
+    static constexpr int nVoices{VoiceGroup::maxVoices}, nLanes{2 * nVoices};
+    std::vector<float> in[nLanes];
+    for (int l = 0; l < nLanes; ++l)
+        in[l] = testSignal(nBlocks * os, 3 + l);
+
+    for (int r = 0; r < 6; ++r)
+    {
+        auto group = std::make_unique<VoiceGroup>();
+        std::unique_ptr<PolysynthVoice> voices[nVoices];
+        for (int i = 0; i < nVoices; ++i)
+        {
+            auto &v = voices[i];
+            v = std::make_unique<PolysynthVoice>(synth);
+            v->attachTo(synth);
+            v->setSampleRate(sampleRate * 2);
+            v->start(0, 0, 60 + 7 * i, -1, 0.8);
+            v->filterRouting = (PolysynthVoice::FilterRouting)r;
+            group->join(*v, VoiceGroup::configFor(*v));
+            v->processBlock();
+        }
+
+        auto qfState = group->qfState;
+        auto wsState = group->wsState;
+        auto fbSignal = group->feedbackSignal;
+        lipol_t drive[nVoices], bias[nVoices], fback[nVoices];
+        for (int i = 0; i < nVoices; ++i)
+        {
+            drive[i] = voices[i]->wsDrive_lipol;
+            bias[i] = voices[i]->wsBias_lipol;
+            fback[i] = voices[i]->filterFeedback_lipol;
+        }
+        std::vector<ReferenceSVF> refs;
+        for (int l = 0; l < nLanes; ++l)
+            refs.emplace_back(group->svf, l);
+        auto mode = voices[0]->svfMode;
+
+        auto renderBlock = [&](size_t b) {
+            for (auto &v : voices)
+            {
+                memcpy(v->outputOS[0], &in[2 * v->groupSlot][b * os], sizeof(v->outputOS[0]));
+                memcpy(v->outputOS[1], &in[2 * v->groupSlot + 1][b * os], sizeof(v->outputOS[1]));
+                group->load(*v);
+            }
+            group->process();
+            for (auto &v : voices)
+                group->unload(*v);
+        };
+
+        double maxErr{0};
+        for (size_t b = 0; b < nBlocks; ++b)
+        {
+            renderBlock(b);
+
+            for (size_t s = 0; s < os; ++s)
+            {
+                float x alignas(16)[4], dl alignas(16)[4], bl alignas(16)[4], fl alignas(16)[4];
+                for (int i = 0; i < nVoices; ++i)
+                {
+                    auto l = 2 * voices[i]->groupSlot;
+                    for (int c = 0; c < 2; ++c)
+                    {
+                        x[l + c] = in[l + c][b * os + s];
+                        dl[l + c] = drive[i].v;
+                        bl[l + c] = bias[i].v;
+                        fl[l + c] = fback[i].v;
+                    }
+                    drive[i].process();
+                    bias[i].process();
+                    fback[i].process();
+                }
+
+                auto v = _mm_add_ps(_mm_load_ps(x), fbSignal);
+                auto dv = _mm_load_ps(dl), bv = _mm_load_ps(bl);
+
+                auto low = [&](__m128 x) { return group->qfPtr(&qfState, x); };
+                auto ws = [&](__m128 x) { return group->wsPtr(&wsState, _mm_add_ps(x, bv), dv); };
+                auto multi = [&](__m128 x) {
+                    float res alignas(16)[4];
+                    for (int l = 0; l < nLanes; ++l)
+                        res[l] = (float)refs[l].step(mode, lane(x, l));
+                    return _mm_load_ps(res);
+                };
+                auto half = [](__m128 a, __m128 b) {
+                    return _mm_mul_ps(_mm_set1_ps(0.5f), _mm_add_ps(a, b));
+                };
+
+                switch (r)
+                {
+                case PolysynthVoice::LowWSMulti:
+                    v = multi(ws(low(v)));
+                    break;
+                case PolysynthVoice::MultiWSLow:
+                    v = low(ws(multi(v)));
+                    break;
+                case PolysynthVoice::WSLowMulti:
+                    v = multi(low(ws(v)));
+                    break;
+                case PolysynthVoice::LowMultiWS:
+                    v = ws(multi(low(v)));
+                    break;
+                case PolysynthVoice::WSPar:
+                {
+                    auto w = ws(v);
+                    v = half(low(w), multi(w));
+                }
+                break;
+                case PolysynthVoice::ParWS:
+                    v = ws(half(low(v), multi(v)));
+                    break;
+                }
+                fbSignal = _mm_mul_ps(v, _mm_load_ps(fl));
+
+                for (auto &vc : voices)
+                {
+                    auto l = 2 * vc->groupSlot;
+                    maxErr = std::max(maxErr, (double)std::fabs(vc->outputOS[0][s] - lane(v, l)));
+                    maxErr =
+                        std::max(maxErr, (double)std::fabs(vc->outputOS[1][s] - lane(v, l + 1)));
+                }
+            }
+        }
+
+        auto t = cb::medianSeconds(iterations, [&]() {
+            for (size_t b = 0; b < nBlocks; ++b)
+                renderBlock(b);
+        });
+
+        // Per voice sample, so this compares directly with the one voice a register loop
+        report(std::string("routing ") + names[r], t * 1e9 / (nBlocks * os * nVoices), maxErr,
+               1e-3);
+    }
+}
+
+double referenceDiode(double v)
+{
+    static constexpr double vb{0.2}, vl{0.5}, h{1.0};
+    if (v < vb)
+        return 0;
+    if (v < vl)
+        return h * (v - vb) * (v - vb) / (2 * vl - 2 * vb);
+    return h * v - h * vl + h * (vl - vb) * (vl - vb) / (2 * vl - 2 * vb);
+}
+
+void benchDiodeRing()
+{
+    static constexpr size_t n{4096};
+    auto in = testSignal(n, 5), src = testSignal(n, 6);
+    for (auto &s : src)
+        s *= 4; // the sidechain is scaled up like this before the bridge
+
+    auto out = in;
+    sst::conduit::ring_modulator::diodeRingModulate(out.data(), src.data(), (int)n);
+
+    double maxErr{0};
+    for (size_t i = 0; i < n; ++i)
+    {
+        double A = 0.5 * in[i] + src[i], B = src[i] - 0.5 * in[i];
+        auto ref = referenceDiode(A) + referenceDiode(-A) - referenceDiode(B) - referenceDiode(-B);
+        maxErr = std::max(maxErr, std::fabs(out[i] - ref));
+    }
+
+    auto t = cb::medianSeconds(iterations, [&]() {
+        memcpy(out.data(), in.data(), n * sizeof(float));
+        sst::conduit::ring_modulator::diodeRingModulate(out.data(), src.data(), (int)n);
+    });
+    report("ring diode bridge", t * 1e9 / n, maxErr, 1e-5);
+}
+
+// Feeds one signal to every input channel and keeps the first output channel
+struct Rendering : cb::ProcessLoop
+{
+    std::vector<float> outL;
+
+    using cb::ProcessLoop::ProcessLoop;
+    bool activate() { return cb::ProcessLoop::activate(::sampleRate, 256); }
+
+    // Runs n samples of in, zero padded; queued param events go in the first block
+    void render(const std::vector<float> &in, size_t n)
+    {
+        outL.clear();
+        for (size_t pos = 0; pos < n; pos += blockSize)
+        {
+            for (auto p = 0U; p < audio.inputPorts(); ++p)
+                for (auto &c : audio.inputs(p))
+                    for (auto i = 0U; i < blockSize; ++i)
+                        c[i] = pos + i < in.size() ? in[pos + i] : 0.f;
+
+            processBlock();
+
+            if (audio.outputPorts() > 0)
+                outL.insert(outL.end(), audio.outputs(0)[0].begin(), audio.outputs(0)[0].end());
+        }
+    }
+};
+
+/*
+ * The delay's tap loop is woven through its process() with lags, VUs and pan
+ * updates, so we drive the whole plugin. Timing is the cost with four taps over
+ * the cost with none, per tap. The check sends an impulse through one tap at a
+ * time with the dry and feedback off and expects the peak where n taps every m
+ * beats puts it.
+ */
+bool startDelay(Rendering &run, int activeTaps)
+{
+    if (!run.activate())
+        return false;
+
+    run.inEvents.param(0, ConduitPolymetricDelay::pmDryLevel, 0);
+    for (int t = 0; t < ConduitPolymetricDelay::nTaps; ++t)
+    {
+        run.inEvents.param(0, ConduitPolymetricDelay::pmTapActive + t, (activeTaps >> t) & 1);
+        run.inEvents.param(0, ConduitPolymetricDelay::pmTapFeedback + t, 0);
+        run.inEvents.param(0, ConduitPolymetricDelay::pmTapCrossFeedback + t, 0);
+    }
+    return true;
+}
+
+bool benchDelayTaps()
+{
+    double worst{0};
+    for (int t = 0; t < ConduitPolymetricDelay::nTaps; ++t)
+    {
+        Rendering run(ConduitPolymetricDelay::getDescription()->id);
+        if (!startDelay(run, 1 << t))
+            return false;
+
+        // The default tap t is 3 + t taps every 2 + t beats
+        auto spb = sampleRate * 60.0 / run.transport.ev.tempo;
+        auto expected = spb * (2 + t) / (3 + t);
+
+        std::vector<float> impulse(1, 1.f);
+        run.render(impulse, (size_t)(expected + 2048));
+
+        size_t peak{0};
+        for (size_t i = 64; i < run.outL.size(); ++i)
+            if (std::fabs(run.outL[i]) > std::fabs(run.outL[peak]))
+                peak = i;
+        worst = std::max(worst, std::fabs(peak - expected));
+    }
+
+    auto timeTaps = [](int mask) {
+        Rendering run(ConduitPolymetricDelay::getDescription()->id);
+        if (!startDelay(run, mask))
+            return -1.0;
+        auto in = testSignal((size_t)sampleRate * 2, 7);
+        run.render({}, run.blockSize * 8); // let the parameter lags settle
+        auto st = std::chrono::steady_clock::now();
+        run.render(in, in.size());
+        auto en = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(en - st).count() / in.size();
+    };
+    auto none = timeTaps(0), all = timeTaps(0xF);
+    if (none < 0 || all < 0)
+        return false;
+
+    // The sinc read and the filters settle a sample or so around the nominal time
+    report("delay tap loop (per tap)", (all - none) * 1e9 / ConduitPolymetricDelay::nTaps, worst,
+           2);
+    return true;
+}
+
+/*
+ * With every tap off the delay's output is its input times the cubed dry level, so
+ * a constant input shows the dry ramp directly. It has to hold exactly until the
+ * event's offset and land on the new level by the end of the block.
+ */
+bool checkDryRamp()
+{
+    Rendering run(ConduitPolymetricDelay::getDescription()->id);
+    if (!startDelay(run, 0))
+        return false;
+
+    std::vector<float> ones(run.blockSize * 2, 1.f);
+    run.inEvents.param(0, ConduitPolymetricDelay::pmDryLevel, 1.0);
+    run.render(ones, ones.size());
+
+    static constexpr uint32_t offset{100};
+    run.inEvents.param(offset, ConduitPolymetricDelay::pmDryLevel, 0.5);
+    run.render(ones, run.blockSize);
+
+    double maxErr{0};
+    for (auto i = 0U; i < offset; ++i)
+        maxErr = std::max(maxErr, std::fabs(run.outL[i] - 1.0));
+    maxErr = std::max(maxErr, std::fabs(run.outL.back() - 0.125));
+    report("delay dry ramp (no timing)", 0, maxErr, 1e-6);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        iterations = std::max(1, std::atoi(argv[1]));
+
+    namespace cpu = sst::conduit::shared::cpu;
+    printf("kernels: %s\n", cpu::levelName(cpu::level()));
+
+    benchSVF<SVF::LP>("LP");
+    benchSVF<SVF::HP>("HP");
+    benchSVF<SVF::BP>("BP");
+    benchSVF<SVF::NOTCH>("NOTCH");
+    benchSVF<SVF::PEAK>("PEAK");
+    benchSVF<SVF::ALL>("ALL");
+    benchSawBank();
+
+    {
+        // The voices read which stages are on from the synth when they start
+        Rendering synth(ConduitPolysynth::getDescription()->id);
+        if (!synth.activate())
+        {
+            fprintf(stderr, "Unable to run the polysynth\n");
+            return 1;
+        }
+        synth.inEvents.param(0, ConduitPolysynth::pmLPFActive, 1);
+        synth.inEvents.param(0, ConduitPolysynth::pmSVFActive, 1);
+        synth.inEvents.param(0, ConduitPolysynth::pmWSActive, 1);
+        synth.render({}, synth.blockSize);
+        benchRouting(*cb::pluginObject<ConduitPolysynth>(synth.inst));
+    }
+
+    benchDiodeRing();
+
+    if (!benchDelayTaps())
+    {
+        fprintf(stderr, "Unable to run the polymetric delay\n");
+        return 1;
+    }
+
+    if (!checkDryRamp())
+    {
+        fprintf(stderr, "Unable to run the polymetric delay\n");
+        return 1;
+    }
+
+    return allPassed ? 0 : 1;
+}
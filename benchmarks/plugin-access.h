@@ -0,0 +1,90 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_BENCHMARKS_PLUGIN_ACCESS_H
+#define CONDUIT_BENCHMARKS_PLUGIN_ACCESS_H
+
+/*
+ * For benchmarks which need to reach past the clap api into one of our plugin
+ * objects, such as to queue a patch load the way the editor does.
+ */
+
+#include <cstring>
+#include <filesystem>
+
+#include "polysynth/polysynth.h"
+#include "polymetric-delay/polymetric-delay.h"
+#include "chord-memory/chord-memory.h"
+#include "ring-modulator/ring-modulator.h"
+#include "clap-event-monitor/clap-event-monitor.h"
+#include "mts-to-noteexpression/mts-to-noteexpression.h"
+#include "midi2-sawsynth/midi2-sawsynth.h"
+#include "multiout-synth/multiout-synth.h"
+
+#include "bench-host.h"
+
+namespace sst::conduit::bench
+{
+// Our plugins keep the helper base in plugin_data, which the as-vst3 extension relies on too
+template <typename T> T *pluginObject(const PluginInstance &inst)
+{
+    return static_cast<T *>(
+        static_cast<sst::conduit::shared::ClapBaseClass<T, typename T::config_t> *>(
+            inst.plugin->plugin_data));
+}
+
+template <typename T> bool isPlugin(const PluginInstance &inst)
+{
+    return strcmp(inst.plugin->desc->id, T::config_t::getDescription()->id) == 0;
+}
+
+// Calls f with the plugin object as its concrete type; false if the id isn't one of ours
+template <typename F> bool withPluginObject(const PluginInstance &inst, F &&f)
+{
+    if (isPlugin<polysynth::ConduitPolysynth>(inst))
+        f(pluginObject<polysynth::ConduitPolysynth>(inst));
+    else if (isPlugin<polymetric_delay::ConduitPolymetricDelay>(inst))
+        f(pluginObject<polymetric_delay::ConduitPolymetricDelay>(inst));
+    else if (isPlugin<chord_memory::ConduitChordMemory>(inst))
+        f(pluginObject<chord_memory::ConduitChordMemory>(inst));
+    else if (isPlugin<ring_modulator::ConduitRingModulator>(inst))
+        f(pluginObject<ring_modulator::ConduitRingModulator>(inst));
+    else if (isPlugin<clap_event_monitor::ConduitClapEventMonitor>(inst))
+        f(pluginObject<clap_event_monitor::ConduitClapEventMonitor>(inst));
+    else if (isPlugin<mts_to_noteexpression::ConduitMTSToNoteExpression>(inst))
+        f(pluginObject<mts_to_noteexpression::ConduitMTSToNoteExpression>(inst));
+    else if (isPlugin<midi2_sawsynth::ConduitMIDI2SawSynth>(inst))
+        f(pluginObject<midi2_sawsynth::ConduitMIDI2SawSynth>(inst));
+    else if (isPlugin<multiout_synth::ConduitMultiOutSynth>(inst))
+        f(pluginObject<multiout_synth::ConduitMultiOutSynth>(inst));
+    else
+        return false;
+    return true;
+}
+
+// Queues a load on the patch worker, which the audio thread then swaps in with a fade
+inline bool requestPatchLoad(const PluginInstance &inst, const std::filesystem::path &p)
+{
+    return withPluginObject(inst, [&p](auto *obj) { obj->uiComms.loadPatch(p); });
+}
+} // namespace sst::conduit::bench
+
+#endif // CONDUIT_BENCHMARKS_PLUGIN_ACCESS_H
@@ -0,0 +1,253 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * Measures how the polysynth's cost scales with the patch. Each point is a fresh
+ * instance with N held notes and a given unison count, filter routing, LPF type
+ * and waveshaper, rendered for a few seconds after a short settle. We report
+ * ns per sample and ns per sample per voice, both warm (blocks back to back)
+ * and cold (the caches evicted before every block, which is closer to a busy
+ * session with many instances). Effects are off unless you ask for them so the
+ * numbers are the voices.
+ *
+ * By default each axis is swept alone around a base patch, plus a voices by
+ * unison grid. --full sweeps the whole product, which takes a while.
+ *
+ * usage: conduit-polysynth-scaling-bench [options]
+ *   --seconds S     measured length per point (default 2)
+ *   --block N       block size (default 256)
+ *   --sr HZ         sample rate (default 48000)
+ *   --evict-mb M    size of the eviction buffer for the cold runs (default 64, 0 skips cold)
+ *   --with-fx       leave the modulation fx and reverb on
+ *   --full          sweep every combination
+ *   --csv           print csv rather than a table
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "polysynth/polysynth.h"
+#include "bench-host.h"
+
+namespace cb = sst::conduit::bench;
+using sst::conduit::polysynth::ConduitPolysynth;
+using sst::conduit::polysynth::PolysynthVoice;
+
+static constexpr const char *routingNames[] = {"Low>WS>Multi", "Multi>WS>Low", "WS>Low>Multi",
+                                               "Low>Multi>WS", "WS>Par",       "Par>WS"};
+static constexpr const char *lpfNames[] = {"OBXD", "Vintage", "K35", "CutWarp", "ResWarp", "Comb"};
+static constexpr const char *wsNames[] = {"Soft", "OJD", "Digital", "FWRect", "WCFold", "Fuzz"};
+
+struct Point
+{
+    const char *axis{"base"};
+    int voices{8}, unison{3}, routing{PolysynthVoice::LowWSMulti},
+        lpf{PolysynthVoice::OBXD}, ws{PolysynthVoice::OJD};
+};
+
+struct Options
+{
+    double seconds{2}, sampleRate{48000};
+    uint32_t blockSize{256};
+    size_t evictBytes{64 << 20};
+    bool withFX{false}, full{false}, csv{false};
+};
+
+struct Result
+{
+    double warmNs{0}, coldNs{0};
+};
+
+/*
+ * Touch every line of a buffer bigger than the last level cache, so the next
+ * block starts with the voices, filters and tables out of cache.
+ */
+struct Evictor
+{
+    std::vector<uint8_t> buffer;
+    uint8_t sink{0};
+
+    explicit Evictor(size_t bytes) : buffer(bytes, 1) {}
+    void evict()
+    {
+        for (size_t i = 0; i < buffer.size(); i += 64)
+        {
+            buffer[i]++;
+            sink ^= buffer[i];
+        }
+    }
+};
+
+// Total seconds spent in process() over the measured blocks
+double renderPoint(const Point &pt, const Options &opt, Evictor *evictor)
+{
+    cb::ProcessLoop loop(ConduitPolysynth::getDescription()->id);
+    if (!loop.activate(opt.sampleRate, opt.blockSize))
+        return -1;
+
+    // The voice reads these at note on, so they go in ahead of the notes in the first block
+    auto setParam = [&](clap_id id, double v) { loop.inEvents.param(0, id, v); };
+    setParam(ConduitPolysynth::pmSawActive, 1);
+    setParam(ConduitPolysynth::pmSawUnisonCount, pt.unison);
+    setParam(ConduitPolysynth::pmLPFActive, 1);
+    setParam(ConduitPolysynth::pmLPFFilterMode, pt.lpf);
+    setParam(ConduitPolysynth::pmSVFActive, 1);
+    setParam(ConduitPolysynth::pmWSActive, 1);
+    setParam(ConduitPolysynth::pmWSMode, pt.ws);
+    setParam(ConduitPolysynth::pmFilterRouting, pt.routing);
+    setParam(ConduitPolysynth::pmEnvS, 1);
+    if (!opt.withFX)
+    {
+        setParam(ConduitPolysynth::pmModFXActive, 0);
+        setParam(ConduitPolysynth::pmRevFXActive, 0);
+    }
+    for (int v = 0; v < pt.voices; ++v)
+        loop.inEvents.note(CLAP_EVENT_NOTE_ON, 0, (int16_t)(36 + v), 0.8);
+
+    auto settleBlocks = (uint64_t)(0.25 * opt.sampleRate / opt.blockSize) + 1;
+    auto measuredBlocks = (uint64_t)(opt.seconds * opt.sampleRate / opt.blockSize) + 1;
+
+    double total{0};
+    for (uint64_t b = 0; b < settleBlocks + measuredBlocks; ++b)
+    {
+        if (evictor)
+            evictor->evict();
+
+        auto t = loop.processBlock();
+        if (b >= settleBlocks)
+            total += t;
+    }
+
+    return total / (measuredBlocks * opt.blockSize);
+}
+
+std::vector<Point> sweepPoints(const Options &opt)
+{
+    std::vector<Point> res;
+    Point base;
+
+    if (opt.full)
+    {
+        for (int v = 1; v <= ConduitPolysynth::max_voices; v *= 2)
+            for (int u = 1; u <= PolysynthVoice::max_uni; ++u)
+                for (int r = 0; r < 6; ++r)
+                    for (int l = 0; l < 6; ++l)
+                        for (int w = 0; w < 6; ++w)
+                            res.push_back({"full", v, u, r, l, w});
+        return res;
+    }
+
+    for (int v = 1; v <= ConduitPolysynth::max_voices; v *= 2)
+        for (int u = 1; u <= PolysynthVoice::max_uni; ++u)
+            res.push_back({"voices x unison", v, u, base.routing, base.lpf, base.ws});
+    for (int r = 0; r < 6; ++r)
+        res.push_back({"routing", base.voices, base.unison, r, base.lpf, base.ws});
+    for (int l = 0; l < 6; ++l)
+        res.push_back({"lpf", base.voices, base.unison, base.routing, l, base.ws});
+    for (int w = 0; w < 6; ++w)
+        res.push_back({"waveshaper", base.voices, base.unison, base.routing, base.lpf, w});
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        auto next = [&]() -> double {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "%s needs a value\n", a.c_str());
+                exit(1);
+            }
+            return std::atof(argv[++i]);
+        };
+
+        if (a == "--seconds")
+            opt.seconds = next();
+        else if (a == "--block")
+            opt.blockSize = (uint32_t)next();
+        else if (a == "--sr")
+            opt.sampleRate = next();
+        else if (a == "--evict-mb")
+            opt.evictBytes = (size_t)(next() * (1 << 20));
+        else if (a == "--with-fx")
+            opt.withFX = true;
+        else if (a == "--full")
+            opt.full = true;
+        else if (a == "--csv")
+            opt.csv = true;
+        else
+        {
+            fprintf(stderr, "Unknown argument '%s'; see the top of polysynth-scaling-bench.cpp\n",
+                    a.c_str());
+            return 1;
+        }
+    }
+
+    if (opt.seconds <= 0 || opt.blockSize == 0 || opt.sampleRate <= 0)
+    {
+        fprintf(stderr, "Sample rate, block size and length must all be positive\n");
+        return 1;
+    }
+
+    std::unique_ptr<Evictor> evictor;
+    if (opt.evictBytes > 0)
+        evictor = std::make_unique<Evictor>(opt.evictBytes);
+
+    if (opt.csv)
+        printf("axis,voices,unison,routing,lpf,ws,warm_ns_per_sample,warm_ns_per_sample_voice,"
+               "cold_ns_per_sample,cold_ns_per_sample_voice\n");
+    else
+        printf("%-16s %6s %4s %-13s %-8s %-8s %12s %12s %12s %7s\n", "axis", "voices", "uni",
+               "routing", "lpf", "ws", "ns/smp", "ns/smp/voice", "cold/voice", "cold/x");
+
+    for (const auto &pt : sweepPoints(opt))
+    {
+        Result r;
+        r.warmNs = renderPoint(pt, opt, nullptr) * 1e9;
+        if (evictor)
+            r.coldNs = renderPoint(pt, opt, evictor.get()) * 1e9;
+        if (r.warmNs < 0 || r.coldNs < 0)
+        {
+            fprintf(stderr, "Unable to create and activate the polysynth\n");
+            return 1;
+        }
+
+        if (opt.csv)
+            printf("%s,%d,%d,%s,%s,%s,%.3f,%.3f,%.3f,%.3f\n", pt.axis, pt.voices, pt.unison,
+                   routingNames[pt.routing], lpfNames[pt.lpf], wsNames[pt.ws], r.warmNs,
+                   r.warmNs / pt.voices, r.coldNs, r.coldNs / pt.voices);
+        else
+            printf("%-16s %6d %4d %-13s %-8s %-8s %12.2f %12.3f %12.3f %7.2f\n", pt.axis,
+                   pt.voices, pt.unison, routingNames[pt.routing], lpfNames[pt.lpf],
+                   wsNames[pt.ws], r.warmNs, r.warmNs / pt.voices, r.coldNs / pt.voices,
+                   evictor ? r.coldNs / r.warmNs : 0.0);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,459 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * conduit-replay plays a capture made with CONDUIT_CAPTURE_DIR set (see
+ * src/conduit-shared/process-capture.h) through a fresh instance of the plugin
+ * which made it. Every block gets the frame count, steady time, transport, events
+ * and input audio it had in the host, starting from the state it had there, so a
+ * CPU spike from someone's session can be reproduced and profiled with no DAW.
+ *
+ * usage: conduit-replay [options] FILE.cndcap
+ *   --repeat N             play it N times, each on a fresh instance, and keep each
+ *                          block's fastest time (default 1)
+ *   --top N                list the N slowest blocks (default 10)
+ *   --wav FILE             write the first output port of the first pass as
+ *                          32 bit float
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "bench-host.h"
+#include "conduit-shared/process-capture.h"
+
+namespace cb = sst::conduit::bench;
+namespace cap = sst::conduit::shared::capture;
+
+struct Record
+{
+    uint32_t tag{0};
+    uint64_t block{0};
+    const uint8_t *data{nullptr};
+    uint32_t size{0};
+};
+
+struct Capture
+{
+    std::string pluginId;
+    std::vector<uint8_t> bytes;
+    std::vector<Record> records;
+    uint32_t maxFrames{0};
+    uint64_t blocks{0}, missingBlocks{0};
+};
+
+// Bounds checked reads through a payload, in host byte order like the writer
+struct Cursor
+{
+    const uint8_t *p, *end;
+
+    const uint8_t *take(size_t n)
+    {
+        if ((size_t)(end - p) < n)
+            return nullptr;
+        auto r = p;
+        p += n;
+        return r;
+    }
+    template <typename V> bool get(V &v)
+    {
+        auto b = take(sizeof(V));
+        if (b)
+            memcpy(&v, b, sizeof(V));
+        return b != nullptr;
+    }
+};
+
+bool readCapture(const std::string &path, Capture &c)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+    {
+        fprintf(stderr, "Unable to open '%s'\n", path.c_str());
+        return false;
+    }
+    c.bytes.assign(std::istreambuf_iterator<char>(in), {});
+
+    Cursor cur{c.bytes.data(), c.bytes.data() + c.bytes.size()};
+    uint32_t magic{0}, version{0}, idLen{0};
+    if (!cur.get(magic) || magic != cap::magic || !cur.get(version) || !cur.get(idLen))
+    {
+        fprintf(stderr, "'%s' is not a conduit capture\n", path.c_str());
+        return false;
+    }
+    if (version != cap::version)
+    {
+        fprintf(stderr, "'%s' is capture version %u; we read %u\n", path.c_str(), version,
+                cap::version);
+        return false;
+    }
+    auto id = cur.take(idLen);
+    if (!id)
+        return false;
+    c.pluginId.assign(reinterpret_cast<const char *>(id), idLen);
+
+    while (cur.p != cur.end)
+    {
+        Record r;
+        if (!cur.get(r.tag) || !cur.get(r.size) || !cur.get(r.block) ||
+            !(r.data = cur.take(r.size)))
+        {
+            // A host which was killed can leave half a record at the end
+            fprintf(stderr, "Ignoring a truncated record at the end of the capture\n");
+            break;
+        }
+        c.records.push_back(r);
+    }
+
+    // Records for a block apply before it runs, whatever order the writer got them in
+    std::stable_sort(c.records.begin(), c.records.end(), [](const auto &a, const auto &b) {
+        auto pa = a.tag == cap::processRecord, pb = b.tag == cap::processRecord;
+        return a.block < b.block || (a.block == b.block && !pa && pb);
+    });
+
+    uint64_t expected{0};
+    for (const auto &r : c.records)
+    {
+        if (r.tag != cap::processRecord)
+            continue;
+        uint32_t frames{0};
+        Cursor pc{r.data + 8, r.data + r.size};
+        if (pc.get(frames))
+            c.maxFrames = std::max(c.maxFrames, frames);
+        c.missingBlocks += r.block - expected;
+        expected = r.block + 1;
+        c.blocks++;
+    }
+    return true;
+}
+
+// Events of any size back to back, 8 byte aligned, as the host gave them
+struct RawEvents
+{
+    std::vector<uint64_t> storage;
+    std::vector<size_t> offsets;
+    clap_input_events_t list{};
+
+    RawEvents()
+    {
+        storage.reserve(1 << 16);
+        offsets.reserve(1024);
+        list.ctx = this;
+        list.size = [](const clap_input_events_t *l) -> uint32_t {
+            return (uint32_t) static_cast<const RawEvents *>(l->ctx)->offsets.size();
+        };
+        list.get = [](const clap_input_events_t *l, uint32_t i) -> const clap_event_header_t * {
+            auto self = static_cast<const RawEvents *>(l->ctx);
+            return reinterpret_cast<const clap_event_header_t *>(self->storage.data() +
+                                                                 self->offsets[i]);
+        };
+    }
+
+    void clear()
+    {
+        storage.clear();
+        offsets.clear();
+    }
+
+    void add(const void *e, uint32_t size)
+    {
+        offsets.push_back(storage.size());
+        storage.resize(storage.size() + (size + 7) / 8);
+        memcpy(storage.data() + offsets.back(), e, size);
+    }
+
+    void param(clap_id id, double value)
+    {
+        clap_event_param_value_t ev{};
+        ev.header = {sizeof(clap_event_param_value_t), 0, CLAP_CORE_EVENT_SPACE_ID,
+                     CLAP_EVENT_PARAM_VALUE, 0};
+        ev.param_id = id;
+        ev.note_id = -1;
+        ev.port_index = -1;
+        ev.channel = -1;
+        ev.key = -1;
+        ev.value = value;
+        add(&ev, sizeof(ev));
+    }
+};
+
+struct BlockInfo
+{
+    uint64_t block{0};
+    uint32_t frames{0}, events{0};
+    double audioSeconds{0}, length{0}, seconds{0};
+};
+
+bool loadState(cb::ProcessLoop &loop, const uint8_t *data, size_t size)
+{
+    auto st = loop.inst.extension<clap_plugin_state>(CLAP_EXT_STATE);
+    if (!st)
+        return size == 0;
+    cb::MemoryIStream in(data, size);
+    return st->load(loop.inst.plugin, &in.stream);
+}
+
+/*
+ * One pass over the capture on a fresh instance, filling the time of each block.
+ * A block whose inputs don't fit the instance is an error rather than a guess.
+ */
+bool replay(const Capture &c, std::vector<BlockInfo> &blocks, cb::WavWriter *wav,
+            const std::string &wavPath)
+{
+    auto loop = std::make_unique<cb::ProcessLoop>(c.pluginId.c_str());
+    if (!loop->inst.plugin)
+    {
+        fprintf(stderr, "This build has no plugin '%s'\n", c.pluginId.c_str());
+        return false;
+    }
+
+    RawEvents events;
+    clap_event_transport_t transport{};
+    double audioSeconds{0};
+    size_t blockOrdinal{0};
+
+    for (const auto &r : c.records)
+    {
+        Cursor cur{r.data, r.data + r.size};
+        switch (r.tag)
+        {
+        case cap::activateRecord:
+        {
+            double sr{0};
+            cur.get(sr);
+            loop->deactivate();
+            if (!loadState(*loop, cur.p, (size_t)(cur.end - cur.p)))
+                fprintf(stderr, "Block %llu: unable to load the activation state\n",
+                        (unsigned long long)r.block);
+            if (!loop->activate(sr, std::max(c.maxFrames, 1U)))
+            {
+                fprintf(stderr, "Unable to activate '%s' at %.0f Hz\n", c.pluginId.c_str(), sr);
+                return false;
+            }
+            loop->process.in_events = &events.list;
+            if (wav && !wav->f && !wavPath.empty() && loop->audio.outputPorts() > 0 &&
+                !wav->open(wavPath, (uint16_t)loop->audio.outputs(0).size(), (uint32_t)sr))
+                fprintf(stderr, "Unable to open '%s'\n", wavPath.c_str());
+            break;
+        }
+        case cap::stateRecord:
+            if (!loadState(*loop, r.data, r.size))
+                fprintf(stderr, "Block %llu: unable to load a captured state\n",
+                        (unsigned long long)r.block);
+            break;
+        case cap::paramRecord:
+        {
+            uint32_t id{0};
+            double value{0};
+            if (cur.get(id) && cur.get(value))
+                events.param(id, value);
+            break;
+        }
+        case cap::processRecord:
+        {
+            if (!loop->active)
+            {
+                fprintf(stderr, "Block %llu comes before any activation\n",
+                        (unsigned long long)r.block);
+                return false;
+            }
+
+            int64_t steadyTime{0};
+            uint32_t frames{0}, transportSize{0}, nEvents{0}, nPorts{0};
+            bool ok = cur.get(steadyTime) && cur.get(frames) && cur.get(transportSize);
+            const uint8_t *tp = ok ? cur.take(transportSize) : nullptr;
+            ok = ok && (transportSize == 0 || tp) && transportSize <= sizeof(transport);
+            if (ok && transportSize)
+                memcpy(&transport, tp, transportSize);
+
+            ok = ok && cur.get(nEvents);
+            for (auto i = 0U; ok && i < nEvents; ++i)
+            {
+                clap_event_header_t h;
+                ok = cur.get(h) && h.size >= sizeof(h);
+                auto body = ok ? cur.take(h.size - sizeof(h)) : nullptr;
+                ok = ok && (body || h.size == sizeof(h));
+                if (ok)
+                    events.add(cur.p - h.size, h.size);
+            }
+
+            ok = ok && cur.get(nPorts);
+            for (auto p = 0U; ok && p < nPorts; ++p)
+            {
+                uint32_t ch{0};
+                ok = cur.get(ch);
+                for (auto k = 0U; ok && k < ch; ++k)
+                {
+                    auto src = cur.take(frames * sizeof(float));
+                    ok = src != nullptr;
+                    if (ok && p < loop->audio.inputPorts() && k < loop->audio.inputs(p).size())
+                        memcpy(loop->audio.inputs(p)[k].data(), src, frames * sizeof(float));
+                }
+            }
+            if (!ok || frames > c.maxFrames)
+            {
+                fprintf(stderr, "Block %llu is malformed\n", (unsigned long long)r.block);
+                return false;
+            }
+
+            loop->process.frames_count = frames;
+            loop->process.steady_time = steadyTime;
+            loop->process.transport = transportSize ? &transport : nullptr;
+
+            auto st = std::chrono::steady_clock::now();
+            loop->inst.plugin->process(loop->inst.plugin, &loop->process);
+            auto en = std::chrono::steady_clock::now();
+            auto secs = std::chrono::duration<double>(en - st).count();
+
+            auto length = frames / loop->sampleRate;
+            if (blockOrdinal == blocks.size())
+                blocks.push_back({r.block, frames, (uint32_t)events.offsets.size(), audioSeconds,
+                                  length, secs});
+            else
+                blocks[blockOrdinal].seconds = std::min(blocks[blockOrdinal].seconds, secs);
+            blockOrdinal++;
+            audioSeconds += length;
+
+            if (wav && wav->f)
+                wav->write(loop->audio.outputs(0), frames);
+            events.clear();
+            break;
+        }
+        default:
+            // A newer writer's record; skip it
+            break;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string capturePath, wavPath;
+    int repeat{1};
+    size_t top{10};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "%s needs a value\n", a.c_str());
+                exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (a == "--repeat")
+            repeat = std::max(std::atoi(next().c_str()), 1);
+        else if (a == "--top")
+            top = (size_t)std::max(std::atoi(next().c_str()), 0);
+        else if (a == "--wav")
+            wavPath = next();
+        else if (a.size() > 2 && a.substr(0, 2) == "--")
+        {
+            fprintf(stderr, "Unknown argument '%s'; see the top of replay-capture.cpp\n",
+                    a.c_str());
+            return 1;
+        }
+        else
+            capturePath = a;
+    }
+
+    if (capturePath.empty())
+    {
+        fprintf(stderr, "usage: conduit-replay [--repeat N] [--top N] [--wav FILE] FILE\n");
+        return 1;
+    }
+
+    Capture capture;
+    if (!readCapture(capturePath, capture))
+        return 1;
+    if (capture.blocks == 0)
+    {
+        fprintf(stderr, "'%s' has no process() calls in it\n", capturePath.c_str());
+        return 1;
+    }
+
+    printf("Replaying %s: %llu blocks of up to %u frames", capture.pluginId.c_str(),
+           (unsigned long long)capture.blocks, capture.maxFrames);
+    if (capture.missingBlocks)
+        printf(", %llu dropped while capturing", (unsigned long long)capture.missingBlocks);
+    printf("\n");
+
+    std::vector<BlockInfo> blocks;
+    cb::WavWriter wav;
+    auto wallStart = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < repeat; ++pass)
+        if (!replay(capture, blocks, pass == 0 ? &wav : nullptr, wavPath))
+            return 1;
+    auto wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart);
+    wav.close();
+
+    // Hosts vary the block size, so each block's budget is its own length
+    double audioSeconds{0}, processSeconds{0};
+    size_t over{0};
+    std::vector<double> times;
+    for (const auto &b : blocks)
+    {
+        times.push_back(b.seconds);
+        audioSeconds += b.length;
+        processSeconds += b.seconds;
+        if (b.seconds > b.length)
+            over++;
+    }
+
+    printf("%.2f s of audio in %.3f s of process() (%.3f s wall for %d pass%s)\n", audioSeconds,
+           processSeconds, wall.count(), repeat, repeat == 1 ? "" : "es");
+    if (processSeconds > 0)
+        printf("realtime factor %.1fx\n", audioSeconds / processSeconds);
+    printf("block time p50 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us  over budget %zu/%zu\n",
+           cb::percentile(times, 0.5) * 1e6, cb::percentile(times, 0.99) * 1e6,
+           cb::percentile(times, 0.999) * 1e6, cb::percentile(times, 1.0) * 1e6, over,
+           times.size());
+
+    std::vector<size_t> order(blocks.size());
+    for (auto i = 0U; i < order.size(); ++i)
+        order[i] = i;
+    top = std::min(top, order.size());
+    std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                      [&blocks](auto a, auto b) { return blocks[a].seconds > blocks[b].seconds; });
+    if (top)
+        printf("slowest blocks\n");
+    for (auto i = 0U; i < top; ++i)
+    {
+        const auto &b = blocks[order[i]];
+        printf("  block %8llu  at %9.3f s  %5u frames  %5u events  %8.1f us\n",
+               (unsigned long long)b.block, b.audioSeconds, b.frames, b.events, b.seconds * 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * Loads plugin state of increasing size, from 1KB up to a few MB, in both the
+ * binary and the legacy XML format and reports the median load time. States are
+ * grown with padding the loaders have to read past (an unknown chunk in binary,
+ * a comment in XML) so the real params and extension still get restored.
+ *
+ * usage: conduit-state-load-bench [plugin-id]
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "conduit-shared/binary-state.h"
+#include "bench-host.h"
+
+namespace cb = sst::conduit::bench;
+namespace bs = sst::conduit::shared::binary_state;
+
+std::vector<uint8_t> padBinary(const std::vector<uint8_t> &base, size_t target)
+{
+    auto res = base;
+    if (target <= res.size() + 8)
+        return res;
+
+    bs::Writer w(res);
+    auto pc = w.beginChunk(bs::fourCC('P', 'A', 'D', 'D'));
+    res.resize(target, 0);
+    w.endChunk(pc);
+    return res;
+}
+
+std::vector<uint8_t> xmlState(const cb::PluginInstance &inst, const char *pluginId, size_t target)
+{
+    auto params = inst.extension<clap_plugin_params>(CLAP_EXT_PARAMS);
+
+    std::string res = "<conduit streamingVersion=\"1\" plugin_id=\"";
+    res += pluginId;
+    res += "\"><params>";
+    for (auto i = 0U; params && i < params->count(inst.plugin); ++i)
+    {
+        clap_param_info info;
+        double value{0};
+        if (!params->get_info(inst.plugin, i, &info) ||
+            !params->get_value(inst.plugin, info.id, &value))
+            continue;
+        res += "<param id=\"" + std::to_string(info.id) + "\" value=\"" + std::to_string(value) +
+               "\" name=\"" + info.name + "\"/>";
+    }
+    res += "</params>";
+
+    static constexpr size_t commentOverhead{7 + 10}; // the comment markers and closing tag
+    if (target > res.size() + commentOverhead)
+    {
+        res += "<!--";
+        res += std::string(target - res.size() - commentOverhead, 'x');
+        res += "-->";
+    }
+    res += "</conduit>";
+    return {res.begin(), res.end()};
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<const char *> ids{"org.surge-synth-team.conduit.polysynth",
+                                  "org.surge-synth-team.conduit.polymetric-delay",
+                                  "org.surge-synth-team.conduit.chord-memory"};
+    if (argc > 1)
+        ids = {argv[1]};
+
+    const std::vector<size_t> sizes{1 << 10, 16 << 10, 64 << 10, 256 << 10, 1 << 20, 4 << 20};
+
+    cb::BenchHost host;
+    printf("%-48s %-6s %10s %12s %10s\n", "plugin", "format", "bytes", "median us", "MB/s");
+
+    for (auto id : ids)
+    {
+        cb::PluginInstance inst(&host.host, id);
+        if (!inst.plugin)
+        {
+            fprintf(stderr, "Unable to create '%s'\n", id);
+            return 1;
+        }
+
+        auto state = inst.extension<clap_plugin_state>(CLAP_EXT_STATE);
+        if (!state)
+        {
+            fprintf(stderr, "'%s' has no state extension\n", id);
+            return 1;
+        }
+
+        cb::MemoryOStream os;
+        if (!state->save(inst.plugin, &os.stream))
+        {
+            fprintf(stderr, "Unable to save state for '%s'\n", id);
+            return 1;
+        }
+
+        for (auto sz : sizes)
+        {
+            for (auto isXml : {false, true})
+            {
+                auto data = isXml ? xmlState(inst, id, sz) : padBinary(os.data, sz);
+
+                // aim for roughly 64MB of parsing per measurement
+                auto iterations = std::clamp((int)((64 << 20) / data.size()), 5, 200);
+                bool ok{true};
+                auto t = cb::medianSeconds(iterations, [&]() {
+                    cb::MemoryIStream is(data.data(), data.size());
+                    ok = ok && state->load(inst.plugin, &is.stream);
+                });
+
+                if (!ok)
+                {
+                    fprintf(stderr, "State load failed for '%s' at %zu bytes (%s)\n", id,
+                            data.size(), isXml ? "xml" : "binary");
+                    return 1;
+                }
+
+                printf("%-48s %-6s %10zu %12.2f %10.1f\n", id, isXml ? "xml" : "binary",
+                       data.size(), t * 1e6, data.size() / t / (1 << 20));
+            }
+        }
+    }
+    return 0;
+}
@@ -61,9 +61,6 @@ ConduitChordMemory::ConduitChordMemory(const clap_host *host)
     configureParams();
 
     attachParam(pmKeyShift, keyShift);
-
-    clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
-    clapJuceShim->setResizable(true);
 }
 
 ConduitChordMemory::~ConduitChordMemory() {}
@@ -94,6 +91,9 @@ bool ConduitChordMemory::notePortsInfo(uint32_t index, bool isInput,
 
 clap_process_status ConduitChordMemory::process(const clap_process *process) noexcept
 {
+    auto timing = processTimingScope(process);
+    auto trace = traceScope("process");
+
     handleEventsFromUIQueue(process->out_events);
 
     auto ev = process->in_events;
@@ -130,12 +130,12 @@ clap_process_status ConduitChordMemory::process(const clap_process *process) noe
                     clap_event_midi mextra;
                     memcpy(&mextra, mevt, sizeof(clap_event_midi));
                     mextra.data[1] += iks;
-                    ov->try_push(ov, (const clap_event_header *)(&mextra));
+                    pushOutputEvent(ov, (const clap_event_header *)(&mextra));
                      */
                 }
                 else
                 {
-                    ov->try_push(ov, evt);
+                    pushOutputEvent(ov, evt);
                 }
             }
             break;
@@ -150,16 +150,17 @@ clap_process_status ConduitChordMemory::process(const clap_process *process) noe
             break;
 
             default:
-                ov->try_push(ov, evt);
+                pushOutputEvent(ov, evt);
                 break;
             }
         }
         else
         {
-            ov->try_push(ov, evt);
+            pushOutputEvent(ov, evt);
         }
     }
 
+    processPatchSwap(process);
     return CLAP_PROCESS_CONTINUE;
 }
 
@@ -171,14 +172,14 @@ void ConduitChordMemory::handleMIDI1NoteChange(const clap_output_events *ov,
     auto nk = std::clamp(key + ks, 0, 127);
     if (updateNoteOnOffData(channel, key, on))
     {
-        ov->try_push(ov, (const clap_event_header *)mevt);
+        pushOutputEvent(ov, (const clap_event_header *)mevt);
     }
     if (updateNoteOnOffData(channel, nk, on))
     {
         clap_event_midi mextra;
         memcpy(&mextra, mevt, sizeof(clap_event_midi));
         mextra.data[1] = nk;
-        ov->try_push(ov, (const clap_event_header *)(&mextra));
+        pushOutputEvent(ov, (const clap_event_header *)(&mextra));
     }
 }
 
@@ -190,14 +191,14 @@ void ConduitChordMemory::handleClapNoteChange(const clap_output_events *ov,
     auto nk = std::clamp(key + ks, 0, 127);
     if (updateNoteOnOffData(nevt->channel, nevt->key, on))
     {
-        ov->try_push(ov, (const clap_event_header *)nevt);
+        pushOutputEvent(ov, (const clap_event_header *)nevt);
     }
     if (updateNoteOnOffData(nevt->channel, nk, on))
     {
         clap_event_note mextra;
         memcpy(&mextra, nevt, sizeof(clap_event_note));
         mextra.key = nk;
-        ov->try_push(ov, (const clap_event_header *)(&mextra));
+        pushOutputEvent(ov, (const clap_event_header *)(&mextra));
     }
 }
 
@@ -205,8 +206,7 @@ bool ConduitChordMemory::updateNoteOnOffData(int16_t channel, int16_t key, bool
 {
     activeNotes[channel][key] += isOn ? 1 : -1;
     auto an = activeNotes[channel][key];
-    CNDOUT << "After note " << (isOn ? "on" : "off") << " at " << channel << " " << key
-           << " resulting an=" << an << std::endl;
+    CNDRTLOG("After note {} at {} {} resulting an={}", isOn ? "on" : "off", channel, key, an);
     return isOn ? an == 1 : an == 0;
 }
 
@@ -226,4 +226,26 @@ bool ConduitChordMemoryConfig::PatchExtension::toXml(TiXmlElement &el)
 
 bool ConduitChordMemoryConfig::PatchExtension::fromXml(TiXmlElement *) { return true; }
 
+bool ConduitChordMemoryConfig::PatchExtension::toBinary(
+    sst::conduit::shared::binary_state::Writer &w) const
+{
+    w.u32(companionNotes.size());
+    for (const auto &c : companionNotes)
+        w.u64(c.to_ullong());
+    return true;
+}
+
+bool ConduitChordMemoryConfig::PatchExtension::fromBinary(
+    sst::conduit::shared::binary_state::Reader &rd)
+{
+    auto n = rd.u32();
+    for (auto i = 0U; i < n && rd.ok; ++i)
+    {
+        auto b = rd.u64();
+        if (rd.ok && i < companionNotes.size())
+            companionNotes[i] = std::bitset<49>(b);
+    }
+    return rd.ok;
+}
+
 } // namespace sst::conduit::chord_memory
@@ -51,6 +51,8 @@ struct ConduitChordMemoryConfig
 
         bool toXml(TiXmlElement &);
         bool fromXml(TiXmlElement *);
+        bool toBinary(sst::conduit::shared::binary_state::Writer &) const;
+        bool fromBinary(sst::conduit::shared::binary_state::Reader &);
     };
 
     struct DataCopyForUI
@@ -76,9 +76,6 @@ ConduitClapEventMonitor::ConduitClapEventMonitor(const clap_host *host)
                                     .withFlags(modFlag));
 
     configureParams();
-
-    clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
-    clapJuceShim->setResizable(true);
 }
 
 ConduitClapEventMonitor::~ConduitClapEventMonitor() {}
@@ -117,6 +114,9 @@ bool ConduitClapEventMonitor::notePortsInfo(uint32_t index, bool isInput,
 }
 clap_process_status ConduitClapEventMonitor::process(const clap_process *process) noexcept
 {
+    auto timing = processTimingScope(process);
+    auto trace = traceScope("process");
+
     auto ev = process->in_events;
     auto ov = process->out_events;
     auto sz = ev->size(ev);
@@ -135,9 +135,10 @@ clap_process_status ConduitClapEventMonitor::process(const clap_process *process
         auto et = ev->get(ev, i);
         uiComms.dataCopyForUI.writeEventTo(et);
 
-        ov->try_push(ov, et);
+        pushOutputEvent(ov, et);
     }
 
+    processPatchSwap(process);
     return CLAP_PROCESS_CONTINUE;
 }
 
@@ -0,0 +1,199 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_BINARY_STATE_H
+#define CONDUIT_SRC_CONDUIT_SHARED_BINARY_STATE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * The binary state format. A stream is
+ *
+ *   u32 magic 'CNDB', u32 formatVersion, u32 streamingVersion, str pluginId
+ *
+ * followed by any number of chunks, each of which is a u32 tag, a u32 payload
+ * length and the payload. Readers skip tags they don't know, so adding a chunk
+ * doesn't need a format bump. Everything is little endian and a str is a u32
+ * length followed by that many bytes.
+ */
+namespace sst::conduit::shared::binary_state
+{
+constexpr uint32_t fourCC(char a, char b, char c, char d)
+{
+    return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) |
+           ((uint32_t)(uint8_t)d << 24);
+}
+
+static constexpr uint32_t magic{fourCC('C', 'N', 'D', 'B')};
+static constexpr uint32_t formatVersion{1};
+
+static constexpr uint32_t paramsChunk{fourCC('P', 'R', 'M', 'S')};    // u32 count, {u32 id, f32}
+static constexpr uint32_t extensionChunk{fourCC('E', 'X', 'T', 'N')}; // PatchExtension blob
+
+inline bool hasMagic(const void *data, size_t size)
+{
+    if (size < 4)
+        return false;
+    auto b = static_cast<const uint8_t *>(data);
+    auto m = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) |
+             ((uint32_t)b[3] << 24);
+    return m == magic;
+}
+
+struct Writer
+{
+    std::vector<uint8_t> &buf;
+    explicit Writer(std::vector<uint8_t> &b) : buf(b) {}
+
+    void u8(uint8_t v) { buf.push_back(v); }
+    void u32(uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+            buf.push_back((uint8_t)((v >> (8 * i)) & 0xFF));
+    }
+    void u64(uint64_t v)
+    {
+        u32((uint32_t)(v & 0xFFFFFFFF));
+        u32((uint32_t)(v >> 32));
+    }
+    void i32(int32_t v) { u32((uint32_t)v); }
+    void f32(float v)
+    {
+        uint32_t u;
+        memcpy(&u, &v, sizeof(u));
+        u32(u);
+    }
+    // A view, so writing a literal id doesn't build a std::string on the audio thread
+    void str(std::string_view s)
+    {
+        u32((uint32_t)s.size());
+        buf.insert(buf.end(), s.begin(), s.end());
+    }
+
+    // Returns the position of the length field, to hand to endChunk when the payload is done
+    size_t beginChunk(uint32_t tag)
+    {
+        u32(tag);
+        auto pos = buf.size();
+        u32(0);
+        return pos;
+    }
+    void endChunk(size_t lengthPos)
+    {
+        auto len = (uint32_t)(buf.size() - lengthPos - 4);
+        for (int i = 0; i < 4; ++i)
+            buf[lengthPos + i] = (uint8_t)((len >> (8 * i)) & 0xFF);
+    }
+};
+
+/*
+ * Reader over a block of memory. Reads past the end set ok to false and return
+ * zero, so callers can read a whole record and check ok once.
+ */
+struct Reader
+{
+    const uint8_t *pos{nullptr}, *end{nullptr};
+    bool ok{true};
+
+    Reader() = default;
+    Reader(const void *data, size_t size)
+        : pos(static_cast<const uint8_t *>(data)), end(static_cast<const uint8_t *>(data) + size)
+    {
+    }
+
+    size_t remaining() const { return (size_t)(end - pos); }
+
+    bool need(size_t n)
+    {
+        if (!ok || remaining() < n)
+        {
+            ok = false;
+            return false;
+        }
+        return true;
+    }
+
+    uint8_t u8()
+    {
+        if (!need(1))
+            return 0;
+        return *pos++;
+    }
+    uint32_t u32()
+    {
+        if (!need(4))
+            return 0;
+        auto r = (uint32_t)pos[0] | ((uint32_t)pos[1] << 8) | ((uint32_t)pos[2] << 16) |
+                 ((uint32_t)pos[3] << 24);
+        pos += 4;
+        return r;
+    }
+    uint64_t u64()
+    {
+        auto lo = (uint64_t)u32();
+        auto hi = (uint64_t)u32();
+        return lo | (hi << 32);
+    }
+    int32_t i32() { return (int32_t)u32(); }
+    float f32()
+    {
+        auto u = u32();
+        float r;
+        memcpy(&r, &u, sizeof(r));
+        return r;
+    }
+    std::string str()
+    {
+        auto n = u32();
+        if (!need(n))
+            return {};
+        auto r = std::string((const char *)pos, n);
+        pos += n;
+        return r;
+    }
+    bool skip(size_t n)
+    {
+        if (!need(n))
+            return false;
+        pos += n;
+        return true;
+    }
+
+    // Read the next chunk header and hand back a reader over its payload
+    bool nextChunk(uint32_t &tag, Reader &payload)
+    {
+        tag = u32();
+        auto len = u32();
+        if (!ok || !need(len))
+            return false;
+        payload = Reader(pos, len);
+        pos += len;
+        return true;
+    }
+};
+} // namespace sst::conduit::shared::binary_state
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_BINARY_STATE_H
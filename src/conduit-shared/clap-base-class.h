@@ -29,6 +29,14 @@
 #include <cassert>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <optional>
 
 #include <tinyxml/tinyxml.h>
 
@@ -36,10 +44,6 @@
 #include <clap/ext/state.h>
 
 #include "sst/cpputils/ring_buffer.h"
-#include "sst/basic-blocks/dsp/Lag.h"
-#include "sst/basic-blocks/tables/DbToLinearProvider.h"
-#include "sst/basic-blocks/tables/EqualTuningProvider.h"
-#include "sst/basic-blocks/tables/TwoToTheXProvider.h"
 #include "sst/plugininfra/paths.h"
 
 // note: this is the extension if you are wrapped as a vst3; it is not any vst3 sdk
@@ -48,6 +52,17 @@
 #include <sst/basic-blocks/params/ParamMetadata.h>
 #include <sst/clap_juce_shim/clap_juce_shim.h>
 #include "debug-helpers.h"
+#include "param-index.h"
+#include "lag-bank.h"
+#include "binary-state.h"
+#include "event-chunks.h"
+#include "param-mirror.h"
+#include "snapshot-publisher.h"
+#include "process-stats.h"
+#include "trace-recorder.h"
+#include "process-capture.h"
+#include "param-ramps.h"
+#include "shared-tables.h"
 
 namespace sst::conduit::shared
 {
@@ -70,19 +85,15 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     ClapBaseClass(const clap_host *host)
         : plugHelper_t(TConfig::getDescription(), host), uiComms(*this)
     {
-        dbToLinearTable.init();
-        equalTuningTable.init();
-        twoToXTable.init();
-        guaranteeDocumentsPath();
+        traceRecorder.startFromEnvironment(TConfig::getDescription()->id);
+        processCapture.startFromEnvironment(TConfig::getDescription()->id);
     }
 
     ClapBaseClass(const clap_plugin_descriptor *desc, const clap_host *host)
         : plugHelper_t(desc, host), uiComms(*this)
     {
-        dbToLinearTable.init();
-        equalTuningTable.init();
-        twoToXTable.init();
-        guaranteeDocumentsPath();
+        traceRecorder.startFromEnvironment(desc->id);
+        processCapture.startFromEnvironment(desc->id);
     }
 
     // Most things are sample accurate, but some have a slow- or block- based approach.
@@ -91,11 +102,17 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
     using ParamDesc = sst::basic_blocks::params::ParamMetaData;
     std::vector<ParamDesc> paramDescriptions;
-    std::unordered_map<uint32_t, ParamDesc> paramDescriptionMap;
 
-    sst::basic_blocks::tables::DbToLinearProvider dbToLinearTable;
-    sst::basic_blocks::tables::EqualTuningProvider equalTuningTable;
-    sst::basic_blocks::tables::TwoToTheXProvider twoToXTable;
+    // Slot order is the order of paramDescriptions, which is also the order of the patch
+    using ParamHandle = sst::conduit::shared::ParamHandle;
+    ParamIndex<TConfig::nParams> paramIndex;
+
+    // Built once per process and shared by every instance; see shared-tables.h
+    const sst::basic_blocks::tables::DbToLinearProvider &dbToLinearTable{
+        tables::curves().dbToLinear};
+    const sst::basic_blocks::tables::EqualTuningProvider &equalTuningTable{
+        tables::curves().equalTuning};
+    const sst::basic_blocks::tables::TwoToTheXProvider &twoToXTable{tables::curves().twoToX};
 
 #define cbassert(x, y)                                                                             \
     {                                                                                              \
@@ -110,17 +127,18 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     {
         cbassert(paramDescriptions.size() == TConfig::nParams,
                  "Incorrect size " << TConfig::nParams << " vs " << paramDescriptions.size());
-        paramDescriptionMap.clear();
+        std::vector<uint32_t> ids;
+        ids.reserve(paramDescriptions.size());
+        for (const auto &pd : paramDescriptions)
+            ids.push_back(pd.id);
+
+        // If you hit this cbassert you have a duplicate param id
+        cbassert(paramIndex.build(ids), "Duplicate Param IDs");
+
         int patchIdx{0};
         for (const auto &pd : paramDescriptions)
         {
-            // If you hit this cbassert you have a duplicate param id
-            cbassert(paramDescriptionMap.find(pd.id) == paramDescriptionMap.end(),
-                     "Duplicate Param IDs");
-            paramDescriptionMap[pd.id] = pd;
-            paramToPatchIndex[pd.id] = patchIdx;
-            paramToValue[pd.id] = &(patch.params[patchIdx]);
-
+            cbassert(paramIndex.find(pd.id) == patchIdx, "Bad Index");
             patch.params[patchIdx] = pd.defaultVal;
             if (TConfig::baseClassProvidesMonoModSupport)
             {
@@ -129,15 +147,31 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
             patchIdx++;
         }
-        cbassert(paramDescriptionMap.size() == TConfig::nParams, "Bad Traversal");
         cbassert(patchIdx == TConfig::nParams, "Bad Traversal");
     }
 
-    bool implementsParams() const noexcept override { return true; }
-    bool isValidParamId(clap_id paramId) const noexcept override
+    /*
+     * Parameter lookup. paramSlot is the perfect hash and is cheap, but DSP code
+     * which reads the same parameter block after block should resolve a handle
+     * once and use paramValue(handle).
+     */
+    int32_t paramSlot(clap_id paramId) const { return paramIndex.find(paramId); }
+    ParamHandle paramHandle(clap_id paramId) const { return {paramIndex.find(paramId)}; }
+    float paramValue(ParamHandle h) const
+    {
+        assert(h.isValid());
+        return patch.params[h.slot];
+    }
+    const ParamDesc *paramDescription(clap_id paramId) const
     {
-        return paramDescriptionMap.find(paramId) != paramDescriptionMap.end();
+        auto slot = paramSlot(paramId);
+        if (slot < 0)
+            return nullptr;
+        return &paramDescriptions[slot];
     }
+
+    bool implementsParams() const noexcept override { return true; }
+    bool isValidParamId(clap_id paramId) const noexcept override { return paramSlot(paramId) >= 0; }
     uint32_t paramsCount() const noexcept override { return TConfig::nParams; }
     bool paramsInfo(uint32_t paramIndex, clap_param_info *info) const noexcept override
     {
@@ -152,7 +186,10 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
     bool paramsValue(clap_id paramId, double *value) noexcept override
     {
-        *value = *paramToValue[paramId];
+        auto slot = paramSlot(paramId);
+        if (slot < 0)
+            return false;
+        *value = patch.params[slot];
         return true;
     }
     bool paramsValueToText(clap_id paramId, double value, char *display,
@@ -169,20 +206,20 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
     std::optional<std::string> paramValueDisplay(clap_id paramId, double value) const
     {
-        auto pos = paramDescriptionMap.find(paramId);
-        if (pos == paramDescriptionMap.end())
+        auto pdp = paramDescription(paramId);
+        if (!pdp)
             return std::nullopt;
 
-        const auto &pd = pos->second;
+        const auto &pd = *pdp;
         ParamDesc::FeatureState fs;
 
         auto tsBuddy = temposyncActivatedBy.find(paramId);
         if (tsBuddy != temposyncActivatedBy.end())
         {
-            auto pvIt = paramToValue.find(tsBuddy->second);
-            if (pvIt != paramToValue.end())
+            auto tsSlot = paramSlot(tsBuddy->second);
+            if (tsSlot >= 0)
             {
-                auto isTS = *(pvIt->second) > 0.5;
+                auto isTS = patch.params[tsSlot] > 0.5;
                 fs = fs.withTemposync(isTS);
             }
         }
@@ -193,11 +230,11 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
     bool paramsTextToValue(clap_id paramId, const char *display, double *value) noexcept override
     {
-        auto pos = paramDescriptionMap.find(paramId);
-        if (pos == paramDescriptionMap.end())
+        auto pdp = paramDescription(paramId);
+        if (!pdp)
             return false;
 
-        const auto &pd = pos->second;
+        const auto &pd = *pdp;
 
         std::string emsg;
         auto res = pd.valueFromString(display, emsg);
@@ -235,24 +272,22 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         }
     } monoModulatedPatch;
 
-    std::unordered_map<clap_id, float *> paramToValue;
-    std::unordered_map<clap_id, int> paramToPatchIndex;
-
-    using lag_t = sst::basic_blocks::dsp::SurgeLag<float, true>;
-    std::unordered_map<clap_id, lag_t *> paramToLag;
+    /*
+     * Smoothed parameters live in the lag bank. Attach a LagHandle, read it with
+     * lagValueAt(handle, offsetIntoSubBlock), and call advanceLags(n) at the end of
+     * each sub-block and before handling events which may retarget a lag.
+     */
+    using LagHandle = sst::conduit::shared::LagHandle;
+    LagBank<TConfig::nParams, blockSize> lagBank;
 
-    void processLags()
-    {
-        for (const auto lp : paramToLag)
-        {
-            lp.second->process();
-        }
-    }
+    void advanceLags(uint32_t samples) { lagBank.advance(samples); }
+    float lagValue(LagHandle h) const { return lagBank.value(h); }
+    float lagValueAt(LagHandle h, uint32_t offset) const { return lagBank.valueAt(h, offset); }
 
     void attachParam(clap_id paramId, float *&to)
     {
-        auto ptpi = paramToPatchIndex.find(paramId);
-        if (ptpi == paramToPatchIndex.end())
+        auto slot = paramSlot(paramId);
+        if (slot < 0)
         {
             to = nullptr;
         }
@@ -260,35 +295,105 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         {
             if (TConfig::baseClassProvidesMonoModSupport)
             {
-                to = &monoModulatedPatch.values[ptpi->second];
+                to = &monoModulatedPatch.values[slot];
             }
             else
             {
-                to = &patch.params[ptpi->second];
+                to = &patch.params[slot];
             }
         }
     }
 
-    void attachParam(clap_id paramId, lag_t &to)
+    void attachParam(clap_id paramId, LagHandle &to)
     {
+        auto slot = paramSlot(paramId);
+        if (slot < 0)
+        {
+            to = LagHandle();
+            return;
+        }
+
         auto val = 0.f;
-        auto ptpi = paramToPatchIndex.find(paramId);
-        if (ptpi != paramToPatchIndex.end())
+        if (TConfig::baseClassProvidesMonoModSupport)
         {
-            if (TConfig::baseClassProvidesMonoModSupport)
-            {
-                val = monoModulatedPatch.values[ptpi->second];
-            }
-            else
+            val = monoModulatedPatch.values[slot];
+        }
+        else
+        {
+            val = patch.params[slot];
+        }
+        to = lagBank.attach(slot, val);
+    }
+
+    /*
+     * Params the DSP wants sample accurate read from paramRamps (see ParamRamps).
+     * Enable a RampHandle, call beginParamRamps at the top of process() once it is
+     * going to render, read whole buffers with renderParamRamp and call endParamRamps
+     * before returning. Inside that window the host's events for ramped params update
+     * the patch and UI once per block rather than once per event.
+     */
+    using RampHandle = sst::conduit::shared::RampHandle;
+    ParamRamps<TConfig::nParams> paramRamps;
+    bool paramRampsInBlock{false};
+
+    void enableParamRamp(clap_id paramId, RampHandle &to)
+    {
+        auto slot = paramSlot(paramId);
+        if (slot < 0)
+        {
+            to = RampHandle();
+            return;
+        }
+        to = paramRamps.enable(slot, patch.params[slot]);
+    }
+
+    void beginParamRamps(const clap_process *process)
+    {
+        paramRamps.beginBlock(process->frames_count);
+        if (!paramRamps.hasRamps())
+            return;
+
+        paramRampsInBlock = true;
+
+        auto ev = process->in_events;
+        auto sz = ev->size(ev);
+        for (auto i = 0U; i < sz; ++i)
+        {
+            auto evt = ev->get(ev, i);
+            if (evt->space_id != CLAP_CORE_EVENT_SPACE_ID || evt->type != CLAP_EVENT_PARAM_VALUE)
+                continue;
+            auto v = reinterpret_cast<const clap_event_param_value *>(evt);
+            paramRamps.addEvent(paramSlot(v->param_id), evt->time, (float)v->value);
+        }
+
+        for (auto r = 0U; r < paramRamps.rampsUsed; ++r)
+        {
+            const auto &rp = paramRamps.ramps[r];
+            if (rp.nPoints == 0)
+                continue;
+            auto id = paramDescriptions[rp.slot].id;
+            doValueUpdate(id, rp.current);
+            pushParamValueToUI(id, rp.current);
+        }
+    }
+
+    // Ramps hold the host value; any mono modulation is added here, at render time
+    void renderParamRamp(RampHandle h, uint32_t start, uint32_t count, float *dst) const
+    {
+        paramRamps.renderInto(h, start, count, dst);
+        if constexpr (TConfig::baseClassProvidesMonoModSupport)
+        {
+            auto mod = monoModulatedPatch.modulations[paramRamps.ramps[h.ramp].slot];
+            if (mod != 0.f)
             {
-                val = patch.params[ptpi->second];
+                for (auto i = 0U; i < count; ++i)
+                    dst[i] += mod;
             }
         }
-        paramToLag[paramId] = &to;
-        to.newValue(val);
-        to.instantize();
     }
 
+    void endParamRamps() { paramRampsInBlock = false; }
+
   protected:
     // This is an OK default implementation but you may want to replace it
     void paramsFlush(const clap_input_events *in, const clap_output_events *out) noexcept override
@@ -307,7 +412,53 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
   public:
     static constexpr int streamingVersion{1};
     bool implementsState() const noexcept override { return true; }
+
+    /*
+     * We save the compact chunked binary format described in binary-state.h. Loading
+     * accepts that or the original XML, told apart by the leading magic, so old
+     * sessions and patches still come back.
+     */
     bool stateSave(const clap_ostream *ostream) noexcept override
+    {
+        std::vector<uint8_t> data;
+        if (!stateToBinary(data))
+            return false;
+        return writeAllToStream(ostream, data.data(), data.size());
+    }
+
+    bool stateToBinary(std::vector<uint8_t> &data) { return stateToBinary(data, patch); }
+    bool stateToBinary(std::vector<uint8_t> &data, const Patch &from)
+    {
+        namespace bs = sst::conduit::shared::binary_state;
+
+        data.reserve(64 + paramDescriptions.size() * 8);
+        bs::Writer w(data);
+        w.u32(bs::magic);
+        w.u32(bs::formatVersion);
+        w.u32(streamingVersion);
+        w.str(TConfig::getDescription()->id);
+
+        auto pc = w.beginChunk(bs::paramsChunk);
+        w.u32(paramDescriptions.size());
+        for (auto slot = 0U; slot < paramDescriptions.size(); ++slot)
+        {
+            w.u32(paramDescriptions[slot].id);
+            w.f32(from.params[slot]);
+        }
+        w.endChunk(pc);
+
+        if constexpr (TConfig::PatchExtension::hasExtension)
+        {
+            auto ec = w.beginChunk(bs::extensionChunk);
+            if (!from.extension.toBinary(w))
+                return false;
+            w.endChunk(ec);
+        }
+        return true;
+    }
+
+    // The original XML format. No longer the default, but readable for debugging
+    bool stateSaveXml(const clap_ostream *ostream)
     {
         TiXmlDocument document;
 
@@ -316,11 +467,12 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         conduit.SetAttribute("plugin_id", TConfig::getDescription()->id);
 
         TiXmlElement paramel("params");
-        for (const auto &a : paramDescriptions)
+        for (auto slot = 0U; slot < paramDescriptions.size(); ++slot)
         {
+            const auto &a = paramDescriptions[slot];
             TiXmlElement par("param");
             par.SetAttribute("id", a.id);
-            par.SetDoubleAttribute("value", *(paramToValue[a.id]));
+            par.SetDoubleAttribute("value", patch.params[slot]);
             par.SetAttribute("name", a.name); // just to debug;
             paramel.InsertEndChild(par);
         }
@@ -340,9 +492,13 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         document.Accept(&pr);
 
         auto xmlS = pr.Str();
+        return writeAllToStream(ostream, xmlS.c_str(), xmlS.length());
+    }
 
-        auto c = xmlS.c_str();
-        auto s = xmlS.length(); // write the null terminator
+    static bool writeAllToStream(const clap_ostream *ostream, const void *data, size_t size)
+    {
+        auto c = static_cast<const char *>(data);
+        auto s = (int64_t)size;
         while (s > 0)
         {
             auto r = ostream->write(ostream, c, s);
@@ -353,34 +509,167 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         }
         return true;
     }
+
+    /*
+     * The stream is pulled in chunks into a heap buffer which we keep between loads,
+     * so state size is bounded only by memory and never sits on the host's stack.
+     *
+     * Like a load from the editor, the state is parsed over the defaults, so anything
+     * it doesn't mention is reset rather than kept, and only copied into the live patch
+     * once it has parsed.
+     */
+    std::vector<char> stateLoadBuffer;
+    Patch stateLoadPatch;
     bool stateLoad(const clap_istream *istream) noexcept override
     {
-        static constexpr uint32_t maxSize = 1 << 16, chunkSize = 1 << 8;
-        char buffer[maxSize];
-        char *bp = &(buffer[0]);
+        static constexpr size_t chunkSize = 1 << 12;
+        auto &buf = stateLoadBuffer;
+        size_t totalRd{0};
         int64_t rd{0};
-        int64_t totalRd{0};
 
-        buffer[0] = 0;
-        while ((rd = istream->read(istream, bp, chunkSize)) > 0)
+        try
+        {
+            do
+            {
+                // leave room for the chunk and a null terminator for the xml parser
+                if (buf.size() < totalRd + chunkSize + 1)
+                    buf.resize(std::max(buf.size() * 2, totalRd + chunkSize + 1));
+
+                rd = istream->read(istream, buf.data() + totalRd, chunkSize);
+                if (rd > 0)
+                    totalRd += rd;
+            } while (rd > 0);
+        }
+        catch (const std::bad_alloc &)
+        {
+            CNDOUT << "Unable to allocate " << totalRd << " bytes for state; Failing" << std::endl;
+            return false;
+        }
+
+        if (rd < 0)
+        {
+            CNDOUT << "Error reading state stream after " << totalRd << " bytes" << std::endl;
+            return false;
+        }
+
+        buf[totalRd] = 0;
+
+        resetPatchToDefaults(stateLoadPatch);
+        if (!stateParse(buf.data(), totalRd, stateLoadPatch))
+            return false;
+
+        copyPatchInPlace(patch, stateLoadPatch);
+        finishStateLoad();
+        captureState();
+        return true;
+    }
+
+    /*
+     * Parse a state into a Patch, leaving every other part of the plugin alone, so
+     * this can run on the patch IO worker against the staged patch. data must be
+     * null terminated at size for the XML parser.
+     */
+    bool stateParse(const char *data, size_t size, Patch &into)
+    {
+        if (binary_state::hasMagic(data, size))
+            return stateParseBinary(data, size, into);
+
+        return stateParseXml(data, into);
+    }
+
+    bool stateParseBinary(const void *data, size_t size, Patch &into)
+    {
+        namespace bs = sst::conduit::shared::binary_state;
+
+        bs::Reader rd(data, size);
+        rd.u32(); // the magic, which got us here
+        auto fv = rd.u32();
+        auto sv = rd.u32();
+        auto spid = rd.str();
+        if (!rd.ok)
+        {
+            CNDOUT << "Binary state too short for header" << std::endl;
+            return false;
+        }
+
+        if (fv > bs::formatVersion)
+        {
+            CNDOUT << "Binary format version '" << fv << "' greater than '" << bs::formatVersion
+                   << "'" << std::endl;
+            return false;
+        }
+
+        if ((int)sv > streamingVersion)
+        {
+            CNDOUT << "Streaming version '" << sv << "' greater than '" << streamingVersion << "'"
+                   << std::endl;
+            return false;
+        }
+
+        if (spid != TConfig::getDescription()->id)
+        {
+            CNDOUT << "State file for '" << spid << "' doesn't match plugin id '"
+                   << TConfig::getDescription()->id << "'" << std::endl;
+            return false;
+        }
+
+        int restoredParams{0};
+        while (rd.remaining() > 0)
         {
-            bp += rd;
-            totalRd += rd;
-            if (totalRd >= maxSize - chunkSize - 1)
+            uint32_t tag;
+            bs::Reader chunk;
+            if (!rd.nextChunk(tag, chunk))
             {
-                CNDOUT << "Input byte stream larger than " << maxSize << "; Failing" << std::endl;
+                CNDOUT << "Truncated chunk in binary state" << std::endl;
                 return false;
             }
+
+            switch (tag)
+            {
+            case bs::paramsChunk:
+            {
+                auto n = chunk.u32();
+                for (auto i = 0U; i < n && chunk.ok; ++i)
+                {
+                    auto id = chunk.u32();
+                    auto value = chunk.f32();
+                    if (chunk.ok && parseParamValue(into, id, value))
+                        restoredParams++;
+                }
+                if (!chunk.ok)
+                {
+                    CNDOUT << "Truncated params chunk in binary state" << std::endl;
+                    return false;
+                }
+            }
+            break;
+            case bs::extensionChunk:
+                if constexpr (TConfig::PatchExtension::hasExtension)
+                {
+                    if (!into.extension.fromBinary(chunk))
+                        return false;
+                }
+                break;
+            default:
+                // Written by a newer version than us; skip it
+                break;
+            }
         }
 
-        if (totalRd < maxSize)
-            buffer[totalRd] = 0;
+        if (restoredParams != TConfig::nParams)
+        {
+            CNDOUT << "Warning : Restored " << restoredParams << " vs expected " << TConfig::nParams
+                   << std::endl;
+        }
 
-        auto xd = std::string(buffer);
+        return true;
+    }
 
+    bool stateParseXml(const char *xd, Patch &into)
+    {
         TiXmlDocument document;
         // I forget how to error check this.
-        document.Parse(xd.c_str());
+        document.Parse(xd);
 
         if (document.Error() != TiXmlBase::TIXML_NO_ERROR)
         {
@@ -457,25 +746,9 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
                 goto nextParam;
             }
 
-            {
-                auto pos = paramToValue.find((clap_id)id);
-                if (pos != paramToValue.end())
-                {
-                    restoredParams++;
-                    *paramToValue[(clap_id)id] = value;
-                }
-                else
-                {
-                    CNDOUT << "Unknown parameter " << id << " in stream" << std::endl;
-                    // continue anyway
-                }
-                auto plv = paramToLag.find(id);
-                if (plv != paramToLag.end())
-                {
-                    plv->second->newValue(value);
-                    plv->second->instantize();
-                }
-            }
+            if (parseParamValue(into, (clap_id)id, value))
+                restoredParams++;
+
         nextParam:
             currParam = TINYXML_SAFE_TO_ELEMENT(currParam->NextSiblingElement("param"));
         }
@@ -491,19 +764,77 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             auto ext = TINYXML_SAFE_TO_ELEMENT(conduit->FirstChild("extension"));
             if (ext)
             {
-                if (!patch.extension.fromXml(ext))
+                if (!into.extension.fromXml(ext))
                 {
                     return false;
                 }
             }
         }
 
+        return true;
+    }
+
+    bool parseParamValue(Patch &into, clap_id id, float value)
+    {
+        auto slot = paramSlot(id);
+        if (slot < 0)
+        {
+            CNDOUT << "Unknown parameter " << id << " in stream" << std::endl;
+            // continue anyway
+            return false;
+        }
+        into.params[slot] = value;
+        return true;
+    }
+
+    void resetPatchToDefaults(Patch &p)
+    {
+        for (auto slot = 0U; slot < paramDescriptions.size(); ++slot)
+            p.params[slot] = paramDescriptions[slot].defaultVal;
+
+        if constexpr (TConfig::PatchExtension::hasExtension)
+        {
+            p.extension = typename TConfig::PatchExtension{};
+            if constexpr (requires { p.extension.initialize(); })
+                p.extension.initialize();
+        }
+    }
+
+    /*
+     * Copy a patch over the live one. Voices and attachParam hold pointers into the live
+     * patch and its extension, so nothing in it is ever freed or replaced; an extension
+     * which owns memory provides assignInPlace to copy into what it already has, which
+     * also keeps this free of allocation on the audio thread.
+     */
+    void copyPatchInPlace(Patch &to, const Patch &from)
+    {
+        std::copy(from.params, from.params + TConfig::nParams, to.params);
+
+        if constexpr (TConfig::PatchExtension::hasExtension)
+        {
+            if constexpr (requires { to.extension.assignInPlace(from.extension); })
+                to.extension.assignInPlace(from.extension);
+            else
+                to.extension = from.extension;
+        }
+    }
+
+    // Once patch holds a newly loaded state, bring the modulation mirror and lags along
+    void finishStateLoad()
+    {
         if (TConfig::baseClassProvidesMonoModSupport)
         {
             monoModulatedPatch.updateAll(patch);
         }
+        for (auto slot = 0U; slot < TConfig::nParams; ++slot)
+        {
+            auto v = TConfig::baseClassProvidesMonoModSupport ? monoModulatedPatch.values[slot]
+                                                              : patch.params[slot];
+            lagBank.newValue(slot, v);
+            lagBank.instantize(slot);
+            paramRamps.setValue(slot, patch.params[slot]);
+        }
         onStateRestored();
-        return true;
     }
 
     virtual void onStateRestored() {}
@@ -516,26 +847,42 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         samplerate = sr;
         sampleRateInv = 1.0 / sr;
         dsamplerate_inv = sampleRateInv; // just an alis
+
+        // Every activate() starts here, so this is where a capture picks up the rate and patch
+        captureState(sr);
     }
 
-    bool implementsGui() const noexcept override { return clapJuceShim != nullptr; }
-    std::unique_ptr<sst::clap_juce_shim::ClapJuceShim> clapJuceShim;
-    ADD_SHIM_IMPLEMENTATION(clapJuceShim)
-    ADD_SHIM_LINUX_TIMER(clapJuceShim)
+    /*
+     * The editor shim is built on the first gui call rather than at construction, since
+     * hosts scanning plugins or loading a big project make many instances which never
+     * show a gui. Plugins set editorResizable in their constructor. Code which may run
+     * before that first gui call, or off the main thread, asks isEditorAttached().
+     */
+    bool editorResizable{true};
+    bool implementsGui() const noexcept override { return true; }
+    mutable std::unique_ptr<sst::clap_juce_shim::ClapJuceShim> clapJuceShim;
+    std::atomic<bool> clapJuceShimReady{false};
 
-    struct ToUI
+    // The gui extension is const in places, hence the mutable shim and the cast
+    std::unique_ptr<sst::clap_juce_shim::ClapJuceShim> &editorShim() const
     {
-        enum MType
+        if (!clapJuceShim)
         {
-            PARAM_VALUE = 0x31,
-            PARAM_MODULATION,
-            MIDI_NOTE_ON,
-            MIDI_NOTE_OFF
-        } type;
+            auto self = const_cast<ClapBaseClass<T, TConfig> *>(this);
+            clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(self);
+            clapJuceShim->setResizable(editorResizable);
+            self->clapJuceShimReady.store(true, std::memory_order_release);
+        }
+        return clapJuceShim;
+    }
+    bool isEditorAttached() const
+    {
+        return clapJuceShimReady.load(std::memory_order_acquire) &&
+               clapJuceShim->isEditorAttached();
+    }
+    ADD_SHIM_IMPLEMENTATION(editorShim())
+    ADD_SHIM_LINUX_TIMER(editorShim())
 
-        uint32_t id;  // param-id for PARAM_VALUE, key for noteon/noteoff
-        double value; // value or unused
-    };
 
     struct FromUI
     {
@@ -544,8 +891,6 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             BEGIN_EDIT = 0xF9,
             END_EDIT,
             ADJUST_VALUE,
-            LOAD_PATCH,
-            SAVE_PATCH,
 
             SPECIALIZED // basically use the id as a router
         } type;
@@ -553,8 +898,6 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
         double value{};
 
-        char *strPointer{nullptr};
-
         template <bool Cond, typename Tp> struct specTypeTrait
         {
             typedef int type;
@@ -569,14 +912,54 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             specializedMessage{};
     };
 
-    /* In the future we will want this off audio thread with a tiny
-     * fade and stuff but not yet. Anticipating that though at least
-     * make a class that does the doohickies so later we can do asynch
-     * of thread etc...
-     *
-     * This implementation misses many basic things including error
-     * handling
+    /*
+     * Patch load and save from the UI happen on a worker thread so file IO and
+     * parsing never touch the audio thread. A load is parsed into stagedPatch and
+     * marked ready; the audio thread then fades out at the end of a block, copies
+     * the staged patch in and fades back up (see processPatchSwap). A save goes the
+     * other way: the worker reserves saveSlotData and asks for it, the audio thread
+     * serializes the patch into it between blocks, where nothing else is writing the
+     * patch, and the worker writes the file. When process() isn't being called, because
+     * we are inactive or the host has stopped processing, the main thread stands in for
+     * the audio thread in both (see standInForPatchSwap). The worker is started the first
+     * time the UI asks for a load or save, and one of each can be in flight at a time.
      */
+    enum StagedPatchState
+    {
+        STAGED_EMPTY,
+        STAGED_READY
+    };
+    std::atomic<int> stagedPatchState{STAGED_EMPTY};
+    Patch stagedPatch;
+
+    enum SaveSlotState
+    {
+        SAVE_IDLE,
+        SAVE_REQUESTED,
+        SAVE_SERIALIZED
+    };
+    std::atomic<int> saveSlotState{SAVE_IDLE};
+    // Set when the save was asked for with a load already staged, so it waits for the swap
+    std::atomic<bool> saveSlotAfterLoad{false};
+    std::vector<uint8_t> saveSlotData;
+
+    // Audio thread between blocks, or main thread when standing in
+    void serviceSaveSlot(bool loadStaged)
+    {
+        if (saveSlotState.load(std::memory_order_acquire) != SAVE_REQUESTED)
+            return;
+        if (loadStaged && saveSlotAfterLoad.load(std::memory_order_acquire))
+            return;
+
+        // The worker reserved well past any state we write, so this doesn't allocate
+        if (!stateToBinary(saveSlotData))
+            saveSlotData.clear();
+        saveSlotState.store(SAVE_SERIALIZED, std::memory_order_release);
+
+        onMainAction |= OnMainAction::WRITE_SAVED_PATCH;
+        _host.requestCallback();
+    }
+
     struct PatchIOHandler
     {
         enum Op
@@ -584,108 +967,469 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             SAVE,
             LOAD
         };
-        // but for now its a hack that just does it directly
-        void enqueueOperation(ClapBaseClass<T, TConfig> &that, Op operation, char *pointerToPath)
+
+        struct Request
+        {
+            Op op;
+            std::filesystem::path path;
+        };
+
+        PatchIOHandler(ClapBaseClass<T, TConfig> &t) : that(t) {}
+        ~PatchIOHandler() { stop(); }
+
+        // Call from the UI (or any non-audio) thread
+        void enqueueOperation(Op operation, const std::filesystem::path &path)
+        {
+            {
+                std::lock_guard<std::mutex> g(mutex);
+                requests.push_back({operation, path});
+                startWorker();
+            }
+            cv.notify_one();
+        }
+
+        // Main thread, once the save slot is serialized
+        void wake()
         {
-            try
             {
-                std::filesystem::path fsp{pointerToPath};
-                delete pointerToPath;
+                std::lock_guard<std::mutex> g(mutex);
+                startWorker();
+            }
+            cv.notify_one();
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> g(mutex);
+                keepRunning = false;
+            }
+            cv.notify_one();
+            if (worker.joinable())
+                worker.join();
+        }
+
+      private:
+        ClapBaseClass<T, TConfig> &that;
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Request> requests;
+        std::atomic<bool> keepRunning{false};
+
+        // Only the worker touches these
+        std::filesystem::path savePath;
+        size_t lastSaveSize{0};
+
+        void startWorker()
+        {
+            if (!worker.joinable())
+            {
+                keepRunning = true;
+                worker = std::thread([this]() { run(); });
+            }
+        }
+
+        bool saveSerialized() const
+        {
+            return that.saveSlotState.load(std::memory_order_acquire) == SAVE_SERIALIZED;
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            while (true)
+            {
+                cv.wait(lk, [this]() {
+                    return !keepRunning || !requests.empty() || saveSerialized();
+                });
+                if (!keepRunning)
+                    break;
+
+                std::optional<Request> r;
+                if (!saveSerialized())
+                {
+                    r = requests.front();
+                    requests.pop_front();
+                }
 
-                if (operation == SAVE)
+                lk.unlock();
+                auto path = r ? r->path : savePath;
+                try
                 {
-                    std::ofstream ofs(fsp, std::ios::out | std::ios::binary);
-                    if (!ofs.is_open())
-                    {
-                        CNDOUT << "Unable to open for writing " << fsp.u8string() << std::endl;
-                        return;
-                    }
-                    CNDOUT << "Writing patch to " << fsp.u8string() << std::endl;
-                    clap_ostream cos{};
-                    cos.ctx = &ofs;
-                    cos.write = clapwrite;
-                    that.stateSave(&cos);
-                    ofs.close();
+                    if (!r)
+                        writeSave();
+                    else if (r->op == SAVE)
+                        requestSave(r->path);
+                    else
+                        load(r->path);
                 }
-                else
+                catch (const std::exception &e)
                 {
-                    std::ifstream ifs(fsp, std::ios::in | std::ios::binary);
-                    if (!ifs.is_open())
-                    {
-                        CNDOUT << "Unable to open for reading " << fsp.u8string() << std::endl;
-                        return;
-                    }
-                    CNDOUT << "Reading patch from " << fsp.u8string() << std::endl;
-                    clap_istream cis{};
-                    cis.ctx = &ifs;
-                    cis.read = clapread;
-                    that.stateLoad(&cis);
-                    ifs.close();
-
-                    that.uiComms.refreshUIValues = true;
-                    if (that._host.canUseParams())
-                    {
-                        that.onMainAction |= OnMainAction::RESCAN;
-                        that._host.requestCallback();
-                    }
+                    CNDOUT << "Patch IO failed for " << path.u8string() << " : " << e.what()
+                           << std::endl;
+                    if (!r)
+                        that.saveSlotState.store(SAVE_IDLE, std::memory_order_release);
                 }
+                lk.lock();
             }
-            catch (const std::filesystem::filesystem_error &e)
+        }
+
+        void requestSave(const std::filesystem::path &fsp)
+        {
+            if (that.saveSlotState.load(std::memory_order_acquire) != SAVE_IDLE)
             {
+                CNDOUT << "A patch save is still pending; not saving " << fsp.u8string()
+                       << std::endl;
+                return;
             }
+
+            savePath = fsp;
+            that.saveSlotData.clear();
+            that.saveSlotData.reserve(std::max<size_t>(1 << 16, lastSaveSize * 2));
+            that.saveSlotAfterLoad.store(
+                that.stagedPatchState.load(std::memory_order_acquire) == STAGED_READY,
+                std::memory_order_release);
+            that.saveSlotState.store(SAVE_REQUESTED, std::memory_order_release);
+
+            // If we aren't processing the audio thread won't come by, so the main thread will
+            that._host.requestCallback();
         }
 
-        static int64_t clapwrite(const clap_ostream *s, const void *buffer, uint64_t size)
+        void writeSave()
         {
-            auto ofs = static_cast<std::ofstream *>(s->ctx);
-            ofs->write((const char *)buffer, size);
-            return size;
+            const auto &data = that.saveSlotData;
+            lastSaveSize = data.size();
+            if (data.empty())
+            {
+                CNDOUT << "Unable to stream patch" << std::endl;
+            }
+            else
+            {
+                std::ofstream ofs(savePath, std::ios::out | std::ios::binary);
+                if (!ofs.is_open())
+                {
+                    CNDOUT << "Unable to open for writing " << savePath.u8string() << std::endl;
+                }
+                else
+                {
+                    CNDOUT << "Writing patch to " << savePath.u8string() << std::endl;
+                    ofs.write((const char *)data.data(), data.size());
+                }
+            }
+            that.saveSlotState.store(SAVE_IDLE, std::memory_order_release);
         }
 
-        static int64_t clapread(const struct clap_istream *s, void *buffer, uint64_t size)
+        void load(const std::filesystem::path &fsp)
         {
-            auto ifs = static_cast<std::ifstream *>(s->ctx);
+            // stagedPatch belongs to the audio thread until it hands it back by emptying it
+            if (that.stagedPatchState.load(std::memory_order_acquire) != STAGED_EMPTY)
+            {
+                CNDOUT << "A patch load is still pending; not loading " << fsp.u8string()
+                       << std::endl;
+                return;
+            }
+
+            std::ifstream ifs(fsp, std::ios::in | std::ios::binary);
+            if (!ifs.is_open())
+            {
+                CNDOUT << "Unable to open for reading " << fsp.u8string() << std::endl;
+                return;
+            }
+            CNDOUT << "Reading patch from " << fsp.u8string() << std::endl;
+            std::vector<char> data{std::istreambuf_iterator<char>(ifs),
+                                   std::istreambuf_iterator<char>()};
+            auto size = data.size();
+            data.push_back(0);
+
+            that.resetPatchToDefaults(that.stagedPatch);
+            if (!that.stateParse(data.data(), size, that.stagedPatch))
+            {
+                CNDOUT << "Unable to parse patch " << fsp.u8string() << std::endl;
+                return;
+            }
+            that.stagedPatchBinary.clear();
+            if (that.processCapture.isActive())
+                that.stateToBinary(that.stagedPatchBinary, that.stagedPatch);
+            that.stagedPatchState.store(STAGED_READY, std::memory_order_release);
+
+            // If we aren't processing the audio thread won't come by, so the main thread will
+            that.onMainAction |= OnMainAction::APPLY_STAGED_PATCH;
+            that._host.requestCallback();
+        }
+    } patchIOHandler{*this};
+
+    /*
+     * Every plugin starts process() with
+     *
+     *   auto timing = processTimingScope(process);
+     *
+     * which feeds the load meter in uiComms.processStats when it goes out of scope
+     * and marks process() as realtime for the CONDUIT_REALTIME_GUARD build.
+     */
+    shared::ProcessTimingScope processTimingScope(const clap_process *process)
+    {
+        waitForMainThreadPatchAccess();
+        if (processCapture.isActive())
+            processCapture.recordProcess(process);
+        return {uiComms.processStats, process->frames_count, sampleRate};
+    }
+
+    /*
+     * Named spans for the Chrome trace when CONDUIT_TRACE_FILE is set. Wrap a phase as
+     *
+     *   { auto ts = traceScope("renderVoices"); renderVoices(); }
+     *
+     * The name must be a string literal.
+     */
+    shared::TraceRecorder traceRecorder;
+
+    // Lets the CNDRTLOG printer start on our first log and joins it with the last instance
+    shared::rtlog::Session rtLogSession;
+    shared::TraceScope traceScope(const char *name) { return {traceRecorder, name}; }
+
+    /*
+     * When CONDUIT_CAPTURE_DIR is set, processTimingScope records each process()
+     * call's events, transport and input audio for conduit-replay. Activations, host
+     * state loads, UI edits and patch swaps are recorded too, so a replay starts from
+     * and follows the same patch, extension and all. Plugins which drain fromUiQ
+     * themselves should call processCapture.recordParamValue for their ADJUST_VALUE
+     * messages.
+     */
+    shared::ProcessCapture processCapture;
+
+    // Main thread. A sample rate marks an activation
+    void captureState(double sr = 0)
+    {
+        if (!processCapture.isActive())
+            return;
+        std::vector<uint8_t> data;
+        if (stateToBinary(data))
+            processCapture.recordState(data, sr);
+    }
+
+    /*
+     * Audio thread, just before a staged patch is copied in. The worker serialized it
+     * into stagedPatchBinary while staging, so this is one copy into the capture ring
+     * and the replay loads the whole patch, extension included, before the next block.
+     */
+    std::vector<uint8_t> stagedPatchBinary;
+    void capturePatchSwap()
+    {
+        if (!processCapture.isActive() || stagedPatchBinary.empty())
+            return;
+        processCapture.recordSwappedState(stagedPatchBinary);
+    }
 
-            // Oh this API is so terrible. I think this is right?
-            ifs->read(static_cast<char *>(buffer), size);
-            if (ifs->rdstate() == std::ios::goodbit || ifs->rdstate() == std::ios::eofbit)
-                return ifs->gcount();
+    // ov->try_push, but counting the events the host refused
+    bool pushOutputEvent(const clap_output_events_t *ov, const clap_event_header_t *evt)
+    {
+        auto res = ov->try_push(ov, evt);
+        if (!res)
+            uiComms.processStats.noteFailedOutputPush();
+        return res;
+    }
 
-            if (ifs->rdstate() & std::ios::eofbit)
-                return ifs->gcount();
+    /*
+     * Call at the end of process() once the outputs are written. When a staged patch
+     * is ready this fades the outputs to silence over patchSwapFadeSamples, copies the
+     * patch in at the block boundary and fades the next block(s) back in. The fade out
+     * always lands on the last sample of a block, stretched over the whole block when
+     * the block is longer than what is left of it, so no block is silenced past the
+     * fade. Plugins with no audio outputs swap straight away. A requested save is
+     * serialized here too, in order with any load around it.
+     */
+    static constexpr uint32_t patchSwapFadeSamples{256};
+    enum PatchSwapFade
+    {
+        FADE_NONE,
+        FADE_OUT,
+        FADE_IN
+    } patchSwapFade{FADE_NONE};
+    uint32_t patchSwapFadePos{0};
 
-            return -1;
+    void processPatchSwap(const clap_process *process)
+    {
+        if (patchSwapFade == FADE_NONE)
+        {
+            auto loadStaged = stagedPatchState.load(std::memory_order_acquire) == STAGED_READY;
+            serviceSaveSlot(loadStaged);
+            if (!loadStaged)
+                return;
+
+            if (process->audio_outputs_count == 0)
+            {
+                capturePatchSwap();
+                applyStagedPatch();
+                return;
+            }
+            patchSwapFade = FADE_OUT;
+            patchSwapFadePos = 0;
+        }
+
+        static constexpr float fadeInv{1.f / patchSwapFadeSamples};
+        auto n = process->frames_count;
+        if (n == 0)
+            return;
+
+        // Gain is g0 + s * dg for the block's sample s
+        float g0, dg;
+        auto fadeDone{false};
+        if (patchSwapFade == FADE_OUT)
+        {
+            auto left = patchSwapFadeSamples - patchSwapFadePos;
+            fadeDone = left <= n;
+            g0 = left * fadeInv;
+            dg = fadeDone ? -g0 / n : -fadeInv;
+            g0 += dg;
+        }
+        else
+        {
+            fadeDone = patchSwapFadePos + n >= patchSwapFadeSamples;
+            g0 = patchSwapFadePos * fadeInv;
+            dg = fadeInv;
+        }
+
+        for (auto o = 0U; o < process->audio_outputs_count; ++o)
+        {
+            const auto &port = process->audio_outputs[o];
+            if (!port.data32)
+                continue;
+            for (auto c = 0U; c < port.channel_count; ++c)
+            {
+                auto *d = port.data32[c];
+                for (auto s = 0U; s < n; ++s)
+                    d[s] *= std::clamp(g0 + s * dg, 0.f, 1.f);
+            }
+        }
+        patchSwapFadePos += n;
+
+        if (fadeDone)
+        {
+            if (patchSwapFade == FADE_OUT)
+            {
+                // Before the apply hands stagedPatchBinary back to the worker
+                capturePatchSwap();
+                applyStagedPatch();
+                patchSwapFade = FADE_IN;
+                patchSwapFadePos = 0;
+            }
+            else
+            {
+                patchSwapFade = FADE_NONE;
+            }
         }
+    }
+
+    void applyStagedPatch()
+    {
+        // stagedPatch stays the worker's to reset, so the live patch can't be freed under us
+        copyPatchInPlace(patch, stagedPatch);
+        finishStateLoad();
+        stagedPatchState.store(STAGED_EMPTY, std::memory_order_release);
 
-    } patchIOHandler;
+        uiComms.refreshUIValues = true;
+        if (_host.canUseParams())
+        {
+            onMainAction |= OnMainAction::RESCAN;
+            _host.requestCallback();
+        }
+    }
 
     enum OnMainAction
     {
-        RESCAN = 1
+        RESCAN = 1,
+        APPLY_STAGED_PATCH = 2,
+        WRITE_SAVED_PATCH = 4
     };
-    int onMainAction{0};
+    std::atomic<int> onMainAction{0};
     void onMainThread() noexcept override
     {
-        if (onMainAction & OnMainAction::RESCAN)
+        auto action = onMainAction.exchange(0);
+        standInForPatchSwap();
+        action |= onMainAction.exchange(0);
+
+        if (action & OnMainAction::WRITE_SAVED_PATCH)
+            patchIOHandler.wake();
+        if (action & OnMainAction::RESCAN)
         {
             _host.paramsRescan(CLAP_PARAM_RESCAN_VALUES | CLAP_PARAM_RESCAN_TEXT);
         }
-        onMainAction = 0;
         Plugin::onMainThread();
     }
 
+    /*
+     * Active but with the host no longer calling process() is as stuck as inactive for
+     * a pending load or save, so the main thread does processPatchSwap's work whenever
+     * the plugin's isProcessing flag is down. The host may start processing again while
+     * it does; mainHasPatch and isProcessing are set and then read by each side in
+     * opposite order, so either we see the flag and leave it to the audio thread, or the
+     * next process() sees mainHasPatch and waits out the apply before touching the patch.
+     * While processing we keep asking for callbacks until the audio thread is done, in
+     * case the host stops before it is.
+     */
+    std::atomic<bool> mainHasPatch{false};
+
+    void standInForPatchSwap()
+    {
+        auto loadStaged = stagedPatchState.load() == STAGED_READY;
+        auto savePending = saveSlotState.load() == SAVE_REQUESTED;
+        if (!loadStaged && !savePending)
+            return;
+
+        mainHasPatch.store(true);
+        if (isActive() && uiComms.dataCopyForUI.isProcessing.load())
+        {
+            mainHasPatch.store(false);
+            _host.requestCallback();
+            return;
+        }
+
+        // In the same order as processPatchSwap, less the fade as nothing is playing
+        serviceSaveSlot(loadStaged);
+        if (loadStaged)
+        {
+            applyStagedPatch();
+            captureState();
+            serviceSaveSlot(false);
+        }
+        patchSwapFade = FADE_NONE;
+        mainHasPatch.store(false, std::memory_order_release);
+    }
+
+    // Audio thread, at the top of process(). Only waits if the host restarted processing
+    // during the short apply above.
+    void waitForMainThreadPatchAccess()
+    {
+        while (mainHasPatch.load())
+            std::this_thread::yield();
+    }
+
     struct UICommunicationBundle
     {
         UICommunicationBundle(ClapBaseClass<T, TConfig> &h) : cp(h) {}
-        typedef sst::cpputils::SimpleRingBuffer<ToUI, 4096> SynthToUI_Queue_t;
-        typedef sst::cpputils::SimpleRingBuffer<FromUI, 4096> UIToSynth_Queue_t;
+        typedef shared::InstrumentedRingBuffer<FromUI, 4096> UIToSynth_Queue_t;
+
+        // Load, latency and queue health for every plugin; see process-stats.h
+        shared::ProcessStats processStats;
 
-        SynthToUI_Queue_t toUiQ;
-        UIToSynth_Queue_t fromUiQ;
+        UIToSynth_Queue_t fromUiQ{processStats.fromUiHighWater};
         typename TConfig::DataCopyForUI dataCopyForUI;
 
+        // Param values go to the editor through here. See param-mirror.h
+        shared::ParamMirror<TConfig::nParams> paramMirror;
+
         std::atomic<bool> refreshUIValues{true};
 
+        // f(id, value) for each param which changed since the last call. Editor thread only.
+        template <typename F> void drainChangedParamValues(F &&f)
+        {
+            paramMirror.drain([&](auto slot, auto v) {
+                if (slot < (int32_t)cp.paramDescriptions.size())
+                    f(cp.paramDescriptions[slot].id, v);
+            });
+        }
+
         void requestHostParamFlush() const
         {
             if (cp._host.canUseParams())
@@ -695,13 +1439,12 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         // todo make this std optional I guess
         ParamDesc getParameterDescription(uint32_t id) const
         {
-            // const so [] isn't an option
-            auto fp = cp.paramDescriptionMap.find(id);
-            if (fp == cp.paramDescriptionMap.end())
+            auto pdp = cp.paramDescription(id);
+            if (!pdp)
             {
                 return ParamDesc();
             }
-            return fp->second;
+            return *pdp;
         }
 
         std::vector<ParamDesc> getAllParamDescriptions() const
@@ -718,7 +1461,17 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             return cp.paramValueDisplay(id, d);
         }
 
-        std::filesystem::path getDocumentsPath() const { return cp.documentsPath; }
+        std::filesystem::path getDocumentsPath() const { return cp.guaranteeDocumentsPath(); }
+
+        // These do the file IO on the patch worker; the audio thread only sees the swap
+        void loadPatch(const std::filesystem::path &p)
+        {
+            cp.patchIOHandler.enqueueOperation(PatchIOHandler::LOAD, p);
+        }
+        void savePatch(const std::filesystem::path &p)
+        {
+            cp.patchIOHandler.enqueueOperation(PatchIOHandler::SAVE, p);
+        }
 
       private:
         // Used to be const but I want to save and load from the UI thread
@@ -726,70 +1479,66 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
         ClapBaseClass<T, TConfig> &cp;
     } uiComms;
 
+    // Found and created on first use, since a plugin which never shows a gui never needs it
     std::filesystem::path documentsPath;
-    void guaranteeDocumentsPath()
+    std::once_flag documentsPathOnce;
+    const std::filesystem::path &guaranteeDocumentsPath()
     {
-        try
-        {
-            auto bp = sst::plugininfra::paths::bestDocumentsFolderPathFor("Conduit");
-            if (!std::filesystem::exists(bp))
+        std::call_once(documentsPathOnce, [this]() {
+            try
             {
-                std::filesystem::create_directories(bp);
+                auto bp = sst::plugininfra::paths::bestDocumentsFolderPathFor("Conduit");
+                if (!std::filesystem::exists(bp))
+                {
+                    std::filesystem::create_directories(bp);
+                }
+                documentsPath = bp;
             }
-            documentsPath = bp;
-        }
-        catch (const std::filesystem::filesystem_error &e)
-        {
-        }
+            catch (const std::filesystem::filesystem_error &e)
+            {
+            }
+        });
+        return documentsPath;
     }
 
     void doValueUpdate(clap_id id, float value)
     {
-        auto ptpi = paramToPatchIndex.find(id);
-        if (ptpi == paramToPatchIndex.end())
+        auto index = paramSlot(id);
+        if (index < 0)
             return;
 
-        int index = ptpi->second;
         patch.params[index] = value;
+        if (!paramRampsInBlock)
+            paramRamps.setValue(index, value);
         if (TConfig::baseClassProvidesMonoModSupport)
         {
             monoModulatedPatch.update(index, patch);
         }
-        auto ptl = paramToLag.find(id);
-        if (ptl != paramToLag.end())
+        if (TConfig::baseClassProvidesMonoModSupport)
         {
-            if (TConfig::baseClassProvidesMonoModSupport)
-            {
-                ptl->second->newValue(monoModulatedPatch.values[index]);
-            }
-            else
-            {
-                ptl->second->newValue(value);
-            }
+            lagBank.newValue(index, monoModulatedPatch.values[index]);
+        }
+        else
+        {
+            lagBank.newValue(index, value);
         }
     }
 
     void doMonoModulationUpdate(clap_id id, float value)
     {
         assert(TConfig::baseClassProvidesMonoModSupport);
-        auto ptpi = paramToPatchIndex.find(id);
-        if (ptpi == paramToPatchIndex.end())
+        auto index = paramSlot(id);
+        if (index < 0)
             return;
 
-        int index = ptpi->second;
         monoModulatedPatch.modulations[index] = value;
         monoModulatedPatch.update(index, patch);
-        auto val = monoModulatedPatch.values[index];
-
-        auto ptl = paramToLag.find(id);
-        if (ptl != paramToLag.end())
-        {
-            ptl->second->newValue(val);
-        }
+        lagBank.newValue(index, monoModulatedPatch.values[index]);
     }
 
     uint32_t handleEventsFromUIQueue(const clap_output_events_t *ov)
     {
+        auto ts = traceScope("uiQueue");
         uint32_t adjustedCount{0};
         while (!uiComms.fromUiQ.empty())
         {
@@ -799,6 +1548,8 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             if (r.type == FromUI::ADJUST_VALUE)
             {
                 doValueUpdate(r.id, r.value);
+                if (processCapture.isActive())
+                    processCapture.recordParamValue(r.id, r.value);
             }
         }
         refreshUIIfNeeded();
@@ -808,19 +1559,13 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
     void refreshUIIfNeeded()
     {
         // Similarly we need to push values to a UI on startup
-        if (uiComms.refreshUIValues && clapJuceShim->isEditorAttached())
+        if (uiComms.refreshUIValues && isEditorAttached())
         {
-            CNDOUT << "Refreshing UI" << std::endl;
+            CNDRTLOG("Refreshing UI");
             uiComms.refreshUIValues = false;
 
-            for (const auto &[k, v] : paramToValue)
-            {
-                auto r = ToUI();
-                r.type = ToUI::PARAM_VALUE;
-                r.id = k;
-                r.value = *v;
-                uiComms.toUiQ.push(r);
-            }
+            for (auto slot = 0U; slot < paramDescriptions.size(); ++slot)
+                uiComms.paramMirror.set((int32_t)slot, patch.params[slot]);
         }
     }
 
@@ -839,7 +1584,7 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             evt.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
             evt.header.flags = 0;
             evt.param_id = r.id;
-            ov->try_push(ov, &evt.header);
+            pushOutputEvent(ov, &evt.header);
         }
         break;
         case FromUI::ADJUST_VALUE:
@@ -854,17 +1599,9 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
             evt.param_id = r.id;
             evt.value = r.value;
 
-            ov->try_push(ov, &(evt.header));
+            pushOutputEvent(ov, &(evt.header));
         }
         break;
-        case FromUI::LOAD_PATCH:
-            // For now just do this. See comment on IO Handler
-            patchIOHandler.enqueueOperation(*this, PatchIOHandler::LOAD, r.strPointer);
-            break;
-        case FromUI::SAVE_PATCH:
-            // For now just do this. See comment on IO Handler
-            patchIOHandler.enqueueOperation(*this, PatchIOHandler::SAVE, r.strPointer);
-            break;
         case FromUI::SPECIALIZED:
             if constexpr (TConfig::usesSpecializedMessages)
             {
@@ -905,30 +1642,28 @@ struct ClapBaseClass : public plugHelper_t, sst::clap_juce_shim::EditorProvider
 
     void updateParamInPatch(const clap_event_param_value *v)
     {
+        // Ramped params were applied once for the whole block by beginParamRamps
+        if (paramRampsInBlock && paramRamps.isRamped(paramSlot(v->param_id)))
+            return;
+
         doValueUpdate(v->param_id, v->value);
-        if (clapJuceShim && clapJuceShim->isEditorAttached())
-        {
-            auto r = ToUI();
-            r.type = ToUI::PARAM_VALUE;
-            r.id = v->param_id;
-            r.value = (double)v->value;
+        pushParamValueToUI(v->param_id, v->value);
+    }
 
-            uiComms.toUiQ.push(r);
-        }
+    /*
+     * The mirror is a store and a bit, so we keep it current whether or not an editor
+     * is open; a newly opened editor then just drains whatever is dirty.
+     */
+    void pushParamValueToUI(clap_id id, double value)
+    {
+        auto slot = paramSlot(id);
+        if (slot >= 0)
+            uiComms.paramMirror.set(slot, (float)value);
     }
 
     void updateModulation(const clap_event_param_mod *v)
     {
         doMonoModulationUpdate(v->param_id, v->amount);
-        if (clapJuceShim && clapJuceShim->isEditorAttached())
-        {
-            auto r = ToUI();
-            r.type = ToUI::PARAM_MODULATION;
-            r.id = v->param_id;
-            r.value = (double)v->amount;
-
-            uiComms.toUiQ.push(r);
-        }
     }
 
     bool registerOrUnregisterTimer(clap_id &id, int ms, bool reg) override
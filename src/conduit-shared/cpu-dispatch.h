@@ -0,0 +1,100 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_CPU_DISPATCH_H
+#define CONDUIT_SRC_CONDUIT_SHARED_CPU_DISPATCH_H
+
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * Conduit builds for baseline SSE2 (or SIMDe on ARM) so one binary runs everywhere. The
+ * few loops where the time goes are compiled a second time with AVX2 and FMA enabled,
+ * and pick between the two at runtime:
+ *
+ *   CONDUIT_FORCE_INLINE void thingKernel(...) { the loop }
+ *   CONDUIT_TARGET_AVX2 void thingAVX2(...) { thingKernel(...); }
+ *   void thing(...)
+ *   {
+ *       if (cpu::useAVX2())
+ *           return thingAVX2(...);
+ *       thingKernel(...);
+ *   }
+ *
+ * The kernel is inlined into each caller and so compiled for each target, along with
+ * the header only library code it calls. The kernels are written with 128 bit _mm_
+ * intrinsics and stay 128 bit in the second copy; it gains the VEX encoding, FMA
+ * contraction where the compiler finds a multiply feeding an add, and any scalar loop
+ * the compiler widens itself. Nothing here is a hand written 256 bit path.
+ *
+ * useAVX2() is cheap but not free, so read it as far out as the loop allows: the ring
+ * modulator takes it once per process() call rather than for each four sample block.
+ *
+ * Where the compiler or architecture can't do
+ * this, or with the CONDUIT_CPU_DISPATCH cmake option off, the macros are empty and
+ * useAVX2() is false, so the second copy is never used.
+ */
+#if CONDUIT_CPU_DISPATCH && (defined(__GNUC__) || defined(__clang__)) &&                           \
+    (defined(__x86_64__) || defined(__i386__))
+#define CONDUIT_HAS_AVX2_VARIANTS 1
+#define CONDUIT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CONDUIT_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define CONDUIT_HAS_AVX2_VARIANTS 0
+#define CONDUIT_TARGET_AVX2
+#define CONDUIT_FORCE_INLINE inline
+#endif
+
+namespace sst::conduit::shared::cpu
+{
+enum class Level
+{
+    Baseline,
+    AVX2
+};
+
+/*
+ * The widest level this machine runs which we have variants for, checked once. Setting
+ * CONDUIT_SIMD=baseline in the environment forces the fallback, so both paths can be
+ * timed and compared on one machine.
+ */
+inline Level level()
+{
+    static const Level detected = []() {
+#if CONDUIT_HAS_AVX2_VARIANTS
+        auto env = std::getenv("CONDUIT_SIMD");
+        if (env && strcmp(env, "baseline") == 0)
+            return Level::Baseline;
+
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return Level::AVX2;
+#endif
+        return Level::Baseline;
+    }();
+    return detected;
+}
+
+inline bool useAVX2() { return level() == Level::AVX2; }
+
+inline const char *levelName(Level l) { return l == Level::AVX2 ? "avx2" : "baseline"; }
+} // namespace sst::conduit::shared::cpu
+#endif
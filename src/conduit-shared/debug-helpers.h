@@ -25,6 +25,15 @@
 // These are just some macros I put in to trace certain lifecycle and value moments to stdout
 #include <iostream>
 #include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <sstream>
+#include <type_traits>
+
+#include "realtime-guard.h"
 
 namespace sst::conduit::shared::details
 {
@@ -46,4 +55,325 @@ inline std::string fixFile(std::string s)
               << __LINE__ << " (" << __func__ << ") : "
 #define CNDVAR(x) " (" << #x << "=" << x << ") "
 
+/*
+ * CNDOUT goes straight to std::cout, which can block on the terminal, so it must
+ * never run on the audio thread. There use
+ *
+ *   CNDRTLOG("After note {} at {} {}", isOn ? "on" : "off", channel, key);
+ *
+ * which copies the format pointer and up to six numeric, bool or string-literal
+ * arguments into a fixed size record on a lock free queue. A background thread,
+ * running while any plugin instance is alive, formats and prints them. Strings
+ * are stored as pointers so they must outlive the call; if the queue is full the
+ * record is dropped and counted.
+ */
+namespace sst::conduit::shared::rtlog
+{
+struct Arg
+{
+    enum Type : uint8_t
+    {
+        NONE,
+        INT,
+        UINT,
+        DOUBLE,
+        BOOL,
+        CSTR
+    } type{NONE};
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        bool b;
+        const char *s;
+    };
+};
+
+template <typename A> inline Arg toArg(A a)
+{
+    Arg r;
+    if constexpr (std::is_same_v<A, bool>)
+    {
+        r.type = Arg::BOOL;
+        r.b = a;
+    }
+    else if constexpr (std::is_enum_v<A> || (std::is_integral_v<A> && std::is_signed_v<A>))
+    {
+        r.type = Arg::INT;
+        r.i = (int64_t)a;
+    }
+    else if constexpr (std::is_integral_v<A>)
+    {
+        r.type = Arg::UINT;
+        r.u = (uint64_t)a;
+    }
+    else if constexpr (std::is_floating_point_v<A>)
+    {
+        r.type = Arg::DOUBLE;
+        r.d = (double)a;
+    }
+    else
+    {
+        static_assert(std::is_convertible_v<A, const char *>,
+                      "CNDRTLOG takes numbers, bools and string literals");
+        r.type = Arg::CSTR;
+        r.s = a;
+    }
+    return r;
+}
+
+static constexpr int maxArgs{6};
+struct Record
+{
+    const char *file{nullptr}, *func{nullptr}, *fmt{nullptr};
+    int line{0};
+    uint8_t nArgs{0};
+    Arg args[maxArgs];
+};
+
+/*
+ * A bounded multi producer queue in the style of Dmitry Vyukov's; every slot carries
+ * a sequence number so producers claim a slot with one CAS and never wait on each
+ * other. Several instances' audio threads can log at once, but only the printer
+ * thread pops.
+ */
+struct Queue
+{
+    static constexpr size_t capacity{1024};
+
+    Queue()
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const Record &r)
+    {
+        auto pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell *c;
+        for (;;)
+        {
+            c = &cells[pos & (capacity - 1)];
+            auto seq = c->seq.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        c->rec = r;
+        c->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(Record &r)
+    {
+        auto pos = dequeuePos;
+        auto &c = cells[pos & (capacity - 1)];
+        if (c.seq.load(std::memory_order_acquire) != pos + 1)
+            return false;
+        r = c.rec;
+        c.seq.store(pos + capacity, std::memory_order_release);
+        dequeuePos = pos + 1;
+        return true;
+    }
+
+    std::atomic<uint64_t> dropped{0};
+
+  private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        Record rec;
+    };
+    Cell cells[capacity];
+    std::atomic<size_t> enqueuePos{0};
+    size_t dequeuePos{0};
+};
+
+inline Queue &queue()
+{
+    static Queue q;
+    return q;
+}
+
+inline std::string format(const Record &r)
+{
+    std::ostringstream oss;
+    int a{0};
+    for (auto p = r.fmt; *p; ++p)
+    {
+        if (p[0] == '{' && p[1] == '}' && a < r.nArgs)
+        {
+            const auto &arg = r.args[a++];
+            switch (arg.type)
+            {
+            case Arg::INT:
+                oss << arg.i;
+                break;
+            case Arg::UINT:
+                oss << arg.u;
+                break;
+            case Arg::DOUBLE:
+                oss << arg.d;
+                break;
+            case Arg::BOOL:
+                oss << (arg.b ? "true" : "false");
+                break;
+            case Arg::CSTR:
+                oss << (arg.s ? arg.s : "(null)");
+                break;
+            case Arg::NONE:
+                break;
+            }
+            ++p;
+        }
+        else
+        {
+            oss << *p;
+        }
+    }
+    return oss.str();
+}
+
+/*
+ * The printer thread. Each plugin instance holds a Session (the base class does this
+ * for you), which only counts users, so instances which never log never start it. The
+ * first log while a Session is alive starts it, and after that each log wakes it
+ * through the pending count, so it sleeps until there is something to print. It is
+ * joined, on the main thread, when the last Session goes away, since a host may unload
+ * the plugin once its instances are gone.
+ */
+struct Printer
+{
+    static Printer &get()
+    {
+        static Printer p;
+        return p;
+    }
+
+    void acquire()
+    {
+        queue(); // make sure the queue is built here, not on the first audio thread log
+        std::lock_guard<std::mutex> g(mutex);
+        users++;
+    }
+    void release()
+    {
+        // The printer never takes the mutex, so we can hold it through the join
+        std::lock_guard<std::mutex> g(mutex);
+        if (--users == 0 && thread.joinable())
+        {
+            running.store(false, std::memory_order_release);
+            wake();
+            thread.join();
+            printAll();
+        }
+    }
+
+    // Any thread, after a push
+    void logged()
+    {
+        if (!running.load(std::memory_order_acquire))
+            start();
+        wake();
+    }
+
+  private:
+    std::mutex mutex;
+    std::thread thread;
+    int users{0};
+    std::atomic<bool> running{false};
+    std::atomic<uint32_t> pending{0};
+    uint64_t lastDropped{0};
+
+    void wake()
+    {
+        pending.fetch_add(1, std::memory_order_release);
+        pending.notify_one();
+    }
+
+    // Once per set of live instances, from whichever thread logs first
+    void start()
+    {
+        realtime_guard::Allow allow;
+        std::lock_guard<std::mutex> g(mutex);
+        if (users == 0 || running.load(std::memory_order_relaxed))
+            return;
+        if (thread.joinable())
+            thread.join();
+        running.store(true, std::memory_order_release);
+        thread = std::thread([this]() { run(); });
+    }
+
+    void printAll()
+    {
+        Record r;
+        while (queue().pop(r))
+        {
+            std::cout << "[conduit] " << details::fixFile(r.file) << ":" << r.line << " ("
+                      << r.func << ") : " << format(r) << std::endl;
+        }
+        auto d = queue().dropped.load(std::memory_order_relaxed);
+        if (d != lastDropped)
+        {
+            std::cout << "[conduit] realtime log dropped " << d - lastDropped << " messages"
+                      << std::endl;
+            lastDropped = d;
+        }
+    }
+
+    void run()
+    {
+        // release clears running before its wake, so reading pending first means we either
+        // see running cleared or wait on a count the wake will move past
+        for (;;)
+        {
+            auto seen = pending.load(std::memory_order_acquire);
+            if (!running.load(std::memory_order_acquire))
+                break;
+            printAll();
+            pending.wait(seen, std::memory_order_acquire);
+        }
+    }
+};
+
+struct Session
+{
+    Session() { Printer::get().acquire(); }
+    ~Session() { Printer::get().release(); }
+    Session(const Session &) = delete;
+    Session &operator=(const Session &) = delete;
+};
+
+template <typename... Args>
+inline void log(const char *file, int line, const char *func, const char *fmt, Args... args)
+{
+    static_assert(sizeof...(Args) <= maxArgs, "CNDRTLOG takes at most six arguments");
+    Record r;
+    r.file = file;
+    r.line = line;
+    r.func = func;
+    r.fmt = fmt;
+    r.nArgs = (uint8_t)sizeof...(Args);
+    int i{0};
+    ((r.args[i++] = toArg(args)), ...);
+    queue().push(r);
+    Printer::get().logged();
+}
+} // namespace sst::conduit::shared::rtlog
+
+#define CNDRTLOG(...) sst::conduit::shared::rtlog::log(__FILE__, __LINE__, __func__, __VA_ARGS__)
+
 #endif // CLAP_SAW_DEMO_DEBUG_HELPERS_H
@@ -22,6 +22,8 @@
 #ifndef CONDUIT_SRC_CONDUIT_SHARED_EDITOR_BASE_H
 #define CONDUIT_SRC_CONDUIT_SHARED_EDITOR_BASE_H
 
+#include <array>
+
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "sst/jucegui/data/Continuous.h"
 #include "sst/jucegui/data/Discrete.h"
@@ -33,6 +35,7 @@
 #include "sst/jucegui/components/MultiSwitch.h"
 #include "sst/jucegui/components/ToolTip.h"
 #include "debug-helpers.h"
+#include "process-stats.h"
 #include "version.h"
 #include "cmrc/cmrc.hpp"
 
@@ -59,6 +62,22 @@ template <typename Content> struct Background : sst::jucegui::components::Window
     std::unique_ptr<juce::Component> contents;
     std::unique_ptr<juce::Component> nameLabel, versionLabel, debugLabel;
 
+    // The DSP load readout in the footer, from uic.processStats a few times a second
+    std::unique_ptr<juce::Label> loadLabel;
+    struct LoadTimer : juce::Timer
+    {
+        Background &bg;
+        LoadTimer(Background &b) : bg(b) {}
+        void timerCallback() override { bg.updateLoadLabel(); }
+    };
+    std::unique_ptr<LoadTimer> loadTimer;
+    uint64_t lastBusyNs{0}, lastBudgetNs{0};
+    // The last loadWindow ticks' histograms, so the p99 follows the last two seconds
+    static constexpr int loadWindow{8};
+    std::array<ProcessStats::Histogram, loadWindow> loadHistograms{};
+    int loadHistogramPos{0};
+    void updateLoadLabel();
+
     std::unique_ptr<sst::jucegui::components::GlyphButton> menuButton;
 
     void loadsave(bool doSave);
@@ -203,34 +222,24 @@ template <typename T, typename TEd> struct EditorCommunicationsHandler
 
     void onIdle()
     {
-        using ToUI = typename T::UICommunicationBundle::SynthToUI_Queue_t::value_type;
-
-        while (!uic.toUiQ.empty())
-        {
-            auto r = *uic.toUiQ.pop();
-
-            if (r.type == ToUI::MType::PARAM_VALUE)
+        // One update per changed param per frame, however much automation arrived
+        uic.drainChangedParamValues([this](auto id, auto value) {
+            auto p = dataTargets.find(id);
+            if (p != dataTargets.end())
             {
-                auto p = dataTargets.find(r.id);
-                if (p != dataTargets.end())
-                {
-                    p->second.second->setValueFromModel(r.value);
-                    p->second.first->repaint();
-                }
-                else
-                {
-                    auto pd = discreteDataTargets.find(r.id);
-                    if (pd != discreteDataTargets.end())
-                    {
-                        pd->second.second->setValueFromModel((int)r.value);
-                        pd->second.first->repaint();
-                    }
-                }
+                p->second.second->setValueFromModel(value);
+                p->second.first->repaint();
             }
             else
             {
+                auto pd = discreteDataTargets.find(id);
+                if (pd != discreteDataTargets.end())
+                {
+                    pd->second.second->setValueFromModel((int)std::round(value));
+                    pd->second.first->repaint();
+                }
             }
-        }
+        });
 
         for (auto &[k, f] : idleHandlers)
         {
@@ -459,6 +468,15 @@ Background<Content>::Background(const std::string &pluginName, const std::string
     debugLabel = std::move(dl);
 #endif
 
+    auto ll = std::make_unique<juce::Label>("DSP Load", "");
+    ll->setColour(juce::Label::ColourIds::textColourId, juce::Colour(160, 160, 170));
+    ll->setFont(vsFont);
+    ll->setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(*ll);
+    loadLabel = std::move(ll);
+    loadTimer = std::make_unique<LoadTimer>(*this);
+    loadTimer->startTimerHz(4);
+
     auto gb = std::make_unique<jcmp::GlyphButton>(jcmp::GlyphPainter::HAMBURGER);
     gb->setOnCallback([w = juce::Component::SafePointer(this)]() {
         if (w)
@@ -486,9 +504,49 @@ template <typename Content> void Background<Content>::resized()
                   .translated(lb.getWidth() - headerSize - 2, 0)
                   .reduced(5);
     menuButton->setBounds(gb);
-    versionLabel->setBounds(lb.withTrimmedTop(lb.getHeight() - footerSize).withTrimmedBottom(2));
+
+    // The footer in thirds: debug warning left, load centre, version right
+    auto footer = lb.withTrimmedTop(lb.getHeight() - footerSize).withTrimmedBottom(2);
+    auto third = footer.getWidth() / 3;
+    auto left = footer.removeFromLeft(third);
+    versionLabel->setBounds(footer.removeFromRight(third));
     if (debugLabel)
-        debugLabel->setBounds(lb.withTrimmedTop(lb.getHeight() - footerSize).withTrimmedBottom(2));
+        debugLabel->setBounds(left);
+    loadLabel->setBounds(footer);
+}
+
+template <typename Content> void Background<Content>::updateLoadLabel()
+{
+    const auto &ps = eb.uic.processStats;
+    if (!ps.enabled)
+    {
+        loadLabel->setText("", juce::dontSendNotification);
+        return;
+    }
+
+    // Load is busy time over block time since the last tick; the p99 is over the window
+    auto hist = ps.snapshot();
+    auto p99 = ProcessStats::percentileSeconds(0.99, loadHistograms[loadHistogramPos], hist);
+    loadHistograms[loadHistogramPos] = hist;
+    loadHistogramPos = (loadHistogramPos + 1) % loadWindow;
+
+    auto busy = ps.busyNs.load(std::memory_order_relaxed);
+    auto budget = ps.budgetNs.load(std::memory_order_relaxed);
+    auto dBusy = busy - lastBusyNs, dBudget = budget - lastBudgetNs;
+    lastBusyNs = busy;
+    lastBudgetNs = budget;
+
+    if (dBudget == 0)
+    {
+        loadLabel->setText("DSP idle", juce::dontSendNotification);
+        return;
+    }
+
+    auto txt = fmt::format("DSP {:.1f}% p99<{:.2f}ms q {}", 100.0 * dBusy / dBudget, p99 * 1000.0,
+                           ps.fromUiHighWater.load());
+    if (auto f = ps.failedOutputPushes.load())
+        txt += fmt::format(" {} lost", f);
+    loadLabel->setText(txt, juce::dontSendNotification);
 }
 
 template <typename Content> void Background<Content>::buildBurger()
@@ -505,6 +563,11 @@ template <typename Content> void Background<Content>::buildBurger()
         if (w)
             w->loadsave(false);
     });
+    menu.addItem("Measure DSP Load", true, eb.uic.processStats.enabled,
+                 [w = juce::Component::SafePointer(this)]() {
+                     if (w)
+                         w->eb.uic.processStats.enabled = !w->eb.uic.processStats.enabled;
+                 });
     menu.addItem("About", []() {});
 
     menu.showMenuAsync(juce::PopupMenu::Options().withParentComponent(this));
@@ -544,8 +607,6 @@ juce::Typeface::Ptr EditorBase<Content>::loadFont(const std::string &path)
 
 template <typename Content> void Background<Content>::loadsave(bool doSave)
 {
-    using FromUI = typename Content::UICommunicationBundle::UIToSynth_Queue_t::value_type;
-
     auto dp = eb.uic.getDocumentsPath();
     if (doSave)
     {
@@ -560,12 +621,8 @@ template <typename Content> void Background<Content>::loadsave(bool doSave)
             {
                 auto file{chooser.getResult()};
 
-                std::string s = file.getFullPathName().toStdString();
-                FromUI sv;
-                sv.type = FromUI::MType::SAVE_PATCH;
-                sv.strPointer = (char *)malloc(s.size() + 1);
-                strncpy(sv.strPointer, s.c_str(), s.size() + 1);
-                this->eb.uic.fromUiQ.push(sv);
+                auto path = std::filesystem::path(file.getFullPathName().toStdString());
+                this->eb.uic.savePatch(path);
             }
         });
     }
@@ -582,12 +639,8 @@ template <typename Content> void Background<Content>::loadsave(bool doSave)
             {
                 auto file{chooser.getResult()};
 
-                std::string s = file.getFullPathName().toStdString();
-                FromUI sv;
-                sv.type = FromUI::MType::LOAD_PATCH;
-                sv.strPointer = (char *)malloc(s.size() + 1);
-                strncpy(sv.strPointer, s.c_str(), s.size() + 1);
-                this->eb.uic.fromUiQ.push(sv);
+                auto path = std::filesystem::path(file.getFullPathName().toStdString());
+                this->eb.uic.loadPatch(path);
             }
         });
     }
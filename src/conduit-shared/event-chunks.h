@@ -0,0 +1,79 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_EVENT_CHUNKS_H
+#define CONDUIT_SRC_CONDUIT_SHARED_EVENT_CHUNKS_H
+
+#include <cstdint>
+#include <algorithm>
+
+#include <clap/events.h>
+#include <clap/process.h>
+
+namespace sst::conduit::shared
+{
+/*
+ * Splits a process block into the maximal runs of samples which contain no events.
+ * Every event is handed to onEvent(const clap_event_header *) in order, at the start
+ * of the run it lands on, and then render(start, end) is called for the half open
+ * run [start, end). So render loops never have to check for an event and can be
+ * written as plain block loops.
+ *
+ * Hosts are supposed to send sorted, in range events but if one is out of order it
+ * is handled at the current position, and events at or past frames_count are
+ * handled after the last run so nothing is dropped.
+ */
+template <typename OnEvent, typename Render>
+inline void processInEventChunks(const clap_process *process, OnEvent &&onEvent, Render &&render)
+{
+    auto ev = process->in_events;
+    auto sz = ev->size(ev);
+    auto frames = process->frames_count;
+
+    uint32_t pos{0}, idx{0};
+    while (pos < frames)
+    {
+        while (idx < sz)
+        {
+            auto e = ev->get(ev, idx);
+            if (e->time > pos)
+                break;
+            onEvent(e);
+            idx++;
+        }
+
+        auto end = frames;
+        if (idx < sz)
+            end = std::min(ev->get(ev, idx)->time, frames);
+
+        render(pos, end);
+        pos = end;
+    }
+
+    while (idx < sz)
+    {
+        onEvent(ev->get(ev, idx));
+        idx++;
+    }
+}
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_EVENT_CHUNKS_H
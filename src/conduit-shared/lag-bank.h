@@ -0,0 +1,137 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_LAG_BANK_H
+#define CONDUIT_SRC_CONDUIT_SHARED_LAG_BANK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cassert>
+
+#include "sse-include.h"
+
+namespace sst::conduit::shared
+{
+struct LagHandle
+{
+    int32_t lane{-1};
+    bool isValid() const { return lane >= 0; }
+};
+
+/*
+ * LagBank holds every smoothed parameter of a plugin as a structure of arrays
+ * and implements the same one pole lag as SurgeLag (v = v * (1-lp) + target * lp).
+ *
+ * Rather than stepping each lag every sample, the DSP code keeps a running
+ * offset into the current sub-block. valueAt(h, offset) gives the per-sample value
+ * in closed form (target + (v - target) * (1-lp)^offset) and advance(n) moves every
+ * lag forward n samples in one SIMD pass. Advance before changing a target (so at
+ * events) and at whatever sub-block boundary suits the plugin.
+ */
+template <size_t N, uint32_t maxSubBlock> struct LagBank
+{
+    static constexpr size_t nLanes{(N + 3) & ~(size_t)3};
+
+    float v alignas(16)[nLanes]{};
+    float target alignas(16)[nLanes]{};
+    int32_t laneForSlot[N];
+    uint32_t lanesUsed{0};
+
+    double lp{0.004}, lpinv{1.0 - 0.004};
+    float decay[maxSubBlock + 1];
+
+    LagBank()
+    {
+        for (auto &l : laneForSlot)
+            l = -1;
+        setRate(0.004);
+    }
+
+    void setRate(double r)
+    {
+        lp = r;
+        lpinv = 1.0 - r;
+        for (auto i = 0U; i <= maxSubBlock; ++i)
+            decay[i] = (float)std::pow(lpinv, (double)i);
+    }
+
+    // Give the param at slot a lane (or find its existing one) starting at value
+    LagHandle attach(int32_t slot, float value)
+    {
+        assert(slot >= 0 && slot < (int32_t)N);
+        if (laneForSlot[slot] < 0)
+        {
+            laneForSlot[slot] = (int32_t)lanesUsed;
+            lanesUsed++;
+        }
+        auto l = laneForSlot[slot];
+        v[l] = value;
+        target[l] = value;
+        return {l};
+    }
+
+    void newValue(int32_t slot, float value)
+    {
+        auto l = laneForSlot[slot];
+        if (l >= 0)
+            target[l] = value;
+    }
+
+    void instantize(int32_t slot)
+    {
+        auto l = laneForSlot[slot];
+        if (l >= 0)
+            v[l] = target[l];
+    }
+
+    float value(LagHandle h) const { return v[h.lane]; }
+    float targetValue(LagHandle h) const { return target[h.lane]; }
+
+    float decayFor(uint32_t n) const
+    {
+        if (n <= maxSubBlock)
+            return decay[n];
+        return (float)std::pow(lpinv, (double)n);
+    }
+
+    inline float valueAt(LagHandle h, uint32_t offset) const
+    {
+        auto t = target[h.lane];
+        return t + (v[h.lane] - t) * decayFor(offset);
+    }
+
+    void advance(uint32_t n)
+    {
+        if (n == 0)
+            return;
+        auto d = _mm_set1_ps(decayFor(n));
+        for (auto i = 0U; i < lanesUsed; i += 4)
+        {
+            auto t = _mm_load_ps(target + i);
+            auto vv = _mm_load_ps(v + i);
+            _mm_store_ps(v + i, _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(vv, t), d)));
+        }
+    }
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_LAG_BANK_H
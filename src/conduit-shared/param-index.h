@@ -0,0 +1,158 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_PARAM_INDEX_H
+#define CONDUIT_SRC_CONDUIT_SHARED_PARAM_INDEX_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+namespace sst::conduit::shared
+{
+/*
+ * A ParamHandle is the dense slot of a parameter in paramDescriptions (and so
+ * in the Patch). DSP code resolves a handle once, usually right after
+ * configureParams, and then reads the value with no lookup at all.
+ */
+struct ParamHandle
+{
+    int32_t slot{-1};
+    bool isValid() const { return slot >= 0; }
+};
+
+/*
+ * ParamIndex maps our sparse clap_ids (1100, 2000, 20025 and so on) onto the
+ * dense slot order. It is a little hash-and-displace perfect hash sized at compile
+ * time from nParams and built once in configureParams. A lookup is two hashes, two
+ * table reads and a key compare, so unknown ids still correctly miss.
+ */
+template <size_t N> struct ParamIndex
+{
+    static constexpr size_t nextPow2(size_t v)
+    {
+        size_t r{1};
+        while (r < v)
+            r <<= 1;
+        return r;
+    }
+    static constexpr size_t tableSize{nextPow2(N * 2 < 8 ? 8 : N * 2)};
+    static constexpr size_t bucketCount{nextPow2(N < 4 ? 4 : N)};
+    static constexpr uint32_t emptyKey{0xFFFFFFFF};
+
+    std::array<uint32_t, bucketCount> displacement{};
+    std::array<uint32_t, tableSize> keys{};
+    std::array<int32_t, tableSize> slots{};
+
+    static inline uint32_t hash(uint32_t k, uint32_t seed)
+    {
+        // murmur3 fmix32 over the seeded key
+        auto h = k ^ (seed * 0x9E3779B9U);
+        h ^= h >> 16;
+        h *= 0x85EBCA6BU;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35U;
+        h ^= h >> 16;
+        return h;
+    }
+
+    /*
+     * Build from the ids in slot order. Returns false if an id is duplicated
+     * or we can't find a displacement (which with a half full table we won't).
+     */
+    bool build(const std::vector<uint32_t> &ids)
+    {
+        keys.fill(emptyKey);
+        slots.fill(-1);
+        displacement.fill(0);
+
+        if (ids.size() > N)
+            return false;
+
+        std::vector<std::vector<int32_t>> buckets(bucketCount);
+        for (auto i = 0U; i < ids.size(); ++i)
+        {
+            if (ids[i] == emptyKey)
+                return false;
+            buckets[hash(ids[i], 0) & (bucketCount - 1)].push_back((int32_t)i);
+        }
+
+        std::vector<size_t> order(bucketCount);
+        for (auto i = 0U; i < bucketCount; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&buckets](auto a, auto b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        std::vector<size_t> placed;
+        for (auto b : order)
+        {
+            const auto &bk = buckets[b];
+            if (bk.empty())
+                break;
+
+            bool found{false};
+            for (uint32_t d = 1; d < (1 << 20) && !found; ++d)
+            {
+                placed.clear();
+                bool ok{true};
+                for (auto s : bk)
+                {
+                    auto pos = hash(ids[s], d) & (tableSize - 1);
+                    if (keys[pos] != emptyKey ||
+                        std::find(placed.begin(), placed.end(), pos) != placed.end())
+                    {
+                        ok = false;
+                        break;
+                    }
+                    placed.push_back(pos);
+                }
+                if (ok)
+                {
+                    for (auto i = 0U; i < bk.size(); ++i)
+                    {
+                        keys[placed[i]] = ids[bk[i]];
+                        slots[placed[i]] = bk[i];
+                    }
+                    displacement[b] = d;
+                    found = true;
+                }
+            }
+
+            // Same key twice in a bucket can never be placed, so this is also our dup check
+            if (!found)
+                return false;
+        }
+        return true;
+    }
+
+    inline int32_t find(uint32_t id) const
+    {
+        auto d = displacement[hash(id, 0) & (bucketCount - 1)];
+        auto pos = hash(id, d) & (tableSize - 1);
+        return keys[pos] == id ? slots[pos] : -1;
+    }
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_PARAM_INDEX_H
@@ -0,0 +1,78 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_PARAM_MIRROR_H
+#define CONDUIT_SRC_CONDUIT_SHARED_PARAM_MIRROR_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+
+namespace sst::conduit::shared
+{
+/*
+ * ParamMirror is how param values get from the audio thread to the editor. Each slot
+ * has an atomic value and a dirty bit; the writer stores the value and sets the bit,
+ * and the reader swaps out a word of dirty bits at a time and reads the latest values.
+ * However dense the automation, the audio thread does one store and one bit set per
+ * change and the UI sees at most one update per param per drain, so nothing can
+ * overflow.
+ */
+template <size_t N> struct ParamMirror
+{
+    static constexpr size_t nWords{(N + 63) / 64};
+
+    std::atomic<float> values[N]{};
+    std::atomic<uint64_t> dirty[nWords]{};
+
+    /*
+     * The bit is set even when it already looks set. The reader may have swapped the word
+     * out since, and only the release on this set makes sure the drain which picks it up
+     * also sees the value; skipping it could lose the last change.
+     */
+    void set(int32_t slot, float v)
+    {
+        values[slot].store(v, std::memory_order_relaxed);
+        dirty[slot >> 6].fetch_or((uint64_t)1 << (slot & 63), std::memory_order_release);
+    }
+
+    float get(int32_t slot) const { return values[slot].load(std::memory_order_relaxed); }
+
+    // f(slot, value) for every slot set since the last drain
+    template <typename F> void drain(F &&f)
+    {
+        for (auto wi = 0U; wi < nWords; ++wi)
+        {
+            auto bits = dirty[wi].exchange(0, std::memory_order_acquire);
+            while (bits)
+            {
+                auto b = std::countr_zero(bits);
+                auto slot = (int32_t)(wi * 64 + b);
+                f(slot, values[slot].load(std::memory_order_relaxed));
+                bits &= bits - 1;
+            }
+        }
+    }
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_PARAM_MIRROR_H
@@ -0,0 +1,181 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_PARAM_RAMPS_H
+#define CONDUIT_SRC_CONDUIT_SHARED_PARAM_RAMPS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+namespace sst::conduit::shared
+{
+struct RampHandle
+{
+    int32_t ramp{-1};
+    bool isValid() const { return ramp >= 0; }
+};
+
+/*
+ * ParamRamps turns the param value events a host sends in one block into linear
+ * segments for the params which opt in. The value the param ended the last block
+ * on holds until the first event's time. Each event then starts a ramp at its own
+ * time, from wherever the value is to the event's value, arriving as the next
+ * event starts or, for the last, at the end of the block. So nothing moves before
+ * the event which asks for it, and the block ends on the last value. Events with
+ * the same timestamp coalesce to the last one, and if a block has more than
+ * maxPoints events the last point is overwritten.
+ *
+ * The DSP then reads whole buffers with renderInto rather than handling each
+ * event. The base class does the scan (see beginParamRamps).
+ */
+template <size_t N, size_t maxRamps = 16, size_t maxPoints = 64> struct ParamRamps
+{
+    struct Point
+    {
+        uint32_t time;
+        float value;
+    };
+
+    struct Ramp
+    {
+        int32_t slot{-1};
+        float current{0.f}, startValue{0.f};
+        uint32_t nPoints{0};
+        Point points[maxPoints];
+    } ramps[maxRamps];
+    uint32_t rampsUsed{0};
+    uint32_t blockFrames{0};
+
+    int32_t rampForSlot[N];
+
+    ParamRamps()
+    {
+        for (auto &r : rampForSlot)
+            r = -1;
+    }
+
+    RampHandle enable(int32_t slot, float value)
+    {
+        assert(slot >= 0 && slot < (int32_t)N);
+        if (rampForSlot[slot] < 0)
+        {
+            assert(rampsUsed < maxRamps);
+            if (rampsUsed >= maxRamps)
+                return {};
+            rampForSlot[slot] = (int32_t)rampsUsed;
+            ramps[rampsUsed].slot = slot;
+            rampsUsed++;
+        }
+        auto &r = ramps[rampForSlot[slot]];
+        r.current = value;
+        r.startValue = value;
+        return {rampForSlot[slot]};
+    }
+
+    bool hasRamps() const { return rampsUsed > 0; }
+    bool isRamped(int32_t slot) const { return slot >= 0 && rampForSlot[slot] >= 0; }
+
+    // An immediate value change from outside a block (UI, flush, state load)
+    void setValue(int32_t slot, float value)
+    {
+        if (!isRamped(slot))
+            return;
+        auto &r = ramps[rampForSlot[slot]];
+        r.current = value;
+        r.startValue = value;
+        r.nPoints = 0;
+    }
+
+    void beginBlock(uint32_t frames)
+    {
+        blockFrames = frames;
+        for (auto i = 0U; i < rampsUsed; ++i)
+        {
+            ramps[i].startValue = ramps[i].current;
+            ramps[i].nPoints = 0;
+        }
+    }
+
+    // Returns false if the slot isn't ramped, in which case the event is the caller's
+    bool addEvent(int32_t slot, uint32_t time, float value)
+    {
+        if (!isRamped(slot))
+            return false;
+        auto &r = ramps[rampForSlot[slot]];
+        if (r.nPoints > 0 && (r.points[r.nPoints - 1].time >= time || r.nPoints == maxPoints))
+        {
+            r.points[r.nPoints - 1].value = value;
+        }
+        else
+        {
+            r.points[r.nPoints] = {time, value};
+            r.nPoints++;
+        }
+        r.current = value;
+        return true;
+    }
+
+    uint32_t eventCount(RampHandle h) const { return ramps[h.ramp].nPoints; }
+    float endValue(RampHandle h) const { return ramps[h.ramp].current; }
+
+    // Write count values starting at sample start of the current block
+    void renderInto(RampHandle h, uint32_t start, uint32_t count, float *dst) const
+    {
+        const auto &r = ramps[h.ramp];
+        if (r.nPoints == 0)
+        {
+            for (auto i = 0U; i < count; ++i)
+                dst[i] = r.startValue;
+            return;
+        }
+
+        float from{r.startValue};
+        auto pos = start;
+        auto end = start + count;
+        for (auto p = 0U; p < r.nPoints && pos < end; ++p)
+        {
+            const auto &pt = r.points[p];
+            auto segStart = pt.time;
+            auto segEnd = p + 1 < r.nPoints ? r.points[p + 1].time : blockFrames;
+            if (segEnd <= segStart)
+                segEnd = segStart + 1;
+
+            for (; pos < end && pos < segStart; ++pos)
+                dst[pos - start] = from;
+
+            // The first sample of the segment takes the first step, the last lands on the value
+            auto dv = (pt.value - from) / (float)(segEnd - segStart);
+            auto v = from + dv * (float)(pos + 1 - segStart);
+            for (; pos < end && pos < segEnd; ++pos)
+            {
+                dst[pos - start] = v;
+                v += dv;
+            }
+            from = pt.value;
+        }
+        for (; pos < end; ++pos)
+            dst[pos - start] = from;
+    }
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_PARAM_RAMPS_H
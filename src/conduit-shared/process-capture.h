@@ -0,0 +1,394 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_PROCESS_CAPTURE_H
+#define CONDUIT_SRC_CONDUIT_SHARED_PROCESS_CAPTURE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <clap/clap.h>
+
+#include "binary-state.h"
+#include "debug-helpers.h"
+
+/*
+ * The capture format. A file is
+ *
+ *   u32 magic 'CNDC', u32 version, u32 id length, the plugin id bytes
+ *
+ * followed by records, each a u32 tag, a u32 payload length, a u64 block index and
+ * the payload. The block index says which process() call, counting from zero, the
+ * record belongs to. State and parameter records apply before that block runs.
+ *
+ *   ACTV  f64 sample rate, then the plugin's binary state at activation
+ *   STAT  the binary state after a host state load or a patch load from the editor
+ *   PARM  u32 param id, f64 value: a UI edit, as of that block
+ *   PROC  i64 steady time, u32 frames,
+ *         u32 transport size, then the transport event if the size isn't zero,
+ *         u32 event count, then the events back to back,
+ *         u32 port count, then for each port u32 channels and frames f32s per channel
+ *
+ * Events are stored as the host sent them, with param cookies cleared and sysex
+ * dropped since both are pointers. Numbers are in host byte order, so replay a
+ * capture on the same kind of machine that made it.
+ */
+namespace sst::conduit::shared::capture
+{
+using binary_state::fourCC;
+
+static constexpr uint32_t magic{fourCC('C', 'N', 'D', 'C')};
+static constexpr uint32_t version{1};
+
+static constexpr uint32_t activateRecord{fourCC('A', 'C', 'T', 'V')};
+static constexpr uint32_t stateRecord{fourCC('S', 'T', 'A', 'T')};
+static constexpr uint32_t paramRecord{fourCC('P', 'A', 'R', 'M')};
+static constexpr uint32_t processRecord{fourCC('P', 'R', 'O', 'C')};
+
+static constexpr uint32_t recordHeaderSize{16};
+static constexpr uint32_t maxEventSize{512};
+} // namespace sst::conduit::shared::capture
+
+namespace sst::conduit::shared
+{
+/*
+ * ProcessCapture records every process() call's inputs so conduit-replay can
+ * run them again without the host. It is off unless CONDUIT_CAPTURE_DIR is set, in
+ * which case each plugin instance writes <dir>/<plugin>-<time>-<n>.cndcap.
+ *
+ * The audio thread serializes each call into a byte ring and a writer thread
+ * appends the ring to the file a few times a second, so all the audio thread
+ * pays is the copy. If the writer falls behind whole blocks are dropped and
+ * counted, and replay reports the gap. Main thread records (activation and state
+ * loads) take a mutex and the allocation of a state save, which is fine there.
+ */
+struct ProcessCapture
+{
+    static constexpr size_t ringSize{1 << 23};
+
+    std::atomic<uint64_t> dropped{0};
+
+    ~ProcessCapture() { stop(); }
+
+    bool isActive() const { return ring != nullptr; }
+
+    void startFromEnvironment(const std::string &pluginId)
+    {
+        auto env = std::getenv("CONDUIT_CAPTURE_DIR");
+        if (!env || !*env)
+            return;
+
+        static std::atomic<int> instanceCount{0};
+        auto shortId = pluginId.substr(pluginId.find_last_of('.') + 1);
+        auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+        auto fn = shortId + "-" + std::to_string(stamp) + "-" + std::to_string(++instanceCount) +
+                  ".cndcap";
+        auto path = std::filesystem::path(env) / fn;
+
+        out.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!out.is_open())
+        {
+            CNDOUT << "Unable to open capture file " << path.u8string() << std::endl;
+            return;
+        }
+        auto u32 = [this](uint32_t v) { out.write(reinterpret_cast<const char *>(&v), 4); };
+        u32(capture::magic);
+        u32(capture::version);
+        u32((uint32_t)pluginId.size());
+        out.write(pluginId.data(), (std::streamsize)pluginId.size());
+
+        ring = std::make_unique<uint8_t[]>(ringSize);
+        writerThread = std::thread([this]() { writerLoop(); });
+        CNDOUT << "Capturing process() to " << path.u8string() << std::endl;
+    }
+
+    void stop()
+    {
+        if (!writerThread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> g(mutex);
+            keepRunning = false;
+        }
+        cv.notify_one();
+        writerThread.join();
+        drain();
+        if (dropped > 0)
+            CNDOUT << "Capture dropped " << dropped << " records" << std::endl;
+        out.close();
+    }
+
+    // Main thread. A zero sample rate records a state load rather than an activation
+    void recordState(const std::vector<uint8_t> &state, double sampleRate = 0)
+    {
+        std::vector<uint8_t> rec;
+        auto isActivation = sampleRate > 0;
+        auto payload = state.size() + (isActivation ? 8 : 0);
+        rec.resize(capture::recordHeaderSize + payload);
+        auto tag = isActivation ? capture::activateRecord : capture::stateRecord;
+        writeHeader(rec.data(), tag, (uint32_t)payload,
+                    blockIndex.load(std::memory_order_acquire));
+        auto *p = rec.data() + capture::recordHeaderSize;
+        if (isActivation)
+        {
+            memcpy(p, &sampleRate, 8);
+            p += 8;
+        }
+        if (!state.empty())
+            memcpy(p, state.data(), state.size());
+
+        std::lock_guard<std::mutex> g(mutex);
+        pending.push_back(std::move(rec));
+    }
+
+    /*
+     * Audio thread, from the top of process() before anything touches the buffers,
+     * since a host may hand us the same buffer for input and output.
+     */
+    void recordProcess(const clap_process *process)
+    {
+        processThread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        auto index = blockIndex.load(std::memory_order_relaxed);
+        blockIndex.store(index + 1, std::memory_order_release);
+
+        auto frames = process->frames_count;
+        auto ev = process->in_events;
+        auto nev = ev ? ev->size(ev) : 0;
+
+        uint32_t eventCount{0}, eventBytes{0};
+        for (auto i = 0U; i < nev; ++i)
+        {
+            auto h = ev->get(ev, i);
+            if (keepEvent(h))
+            {
+                eventCount++;
+                eventBytes += h->size;
+            }
+        }
+
+        uint64_t payload = 8 + 4 + 4 + (process->transport ? sizeof(clap_event_transport_t) : 0) +
+                           4 + eventBytes + 4;
+        for (auto p = 0U; p < process->audio_inputs_count; ++p)
+            payload += 4 + (uint64_t)channelsOf(process->audio_inputs[p]) * frames * 4;
+
+        if (!reserve(capture::recordHeaderSize + payload))
+            return;
+
+        uint8_t hdr[capture::recordHeaderSize];
+        writeHeader(hdr, capture::processRecord, (uint32_t)payload, index);
+        put(hdr, sizeof(hdr));
+        putValue(process->steady_time);
+        putValue(frames);
+        if (process->transport)
+        {
+            putValue((uint32_t)sizeof(clap_event_transport_t));
+            put(process->transport, sizeof(clap_event_transport_t));
+        }
+        else
+        {
+            putValue((uint32_t)0);
+        }
+
+        putValue(eventCount);
+        for (auto i = 0U; i < nev; ++i)
+        {
+            auto h = ev->get(ev, i);
+            if (!keepEvent(h))
+                continue;
+            alignas(8) uint8_t scratch[capture::maxEventSize];
+            memcpy(scratch, h, h->size);
+            clearCookie(scratch);
+            put(scratch, h->size);
+        }
+
+        putValue(process->audio_inputs_count);
+        for (auto p = 0U; p < process->audio_inputs_count; ++p)
+        {
+            const auto &port = process->audio_inputs[p];
+            auto ch = channelsOf(port);
+            putValue(ch);
+            for (auto c = 0U; c < ch; ++c)
+                put(port.data32[c], frames * sizeof(float));
+        }
+        publish();
+    }
+
+    /*
+     * A parameter change which didn't come from the host's events. UI edits land
+     * in the block being processed when made from process() and before the next
+     * one otherwise; a patch swap always lands before the next one.
+     */
+    void recordParamValue(clap_id id, double value, bool forNextBlock = false)
+    {
+        auto index = blockIndex.load(std::memory_order_relaxed);
+        auto thisThread = std::this_thread::get_id();
+        auto inProcess = thisThread == processThread.load(std::memory_order_relaxed);
+        if (!forNextBlock && inProcess && index > 0)
+            index--;
+
+        if (!reserve(capture::recordHeaderSize + 12))
+            return;
+        uint8_t hdr[capture::recordHeaderSize];
+        writeHeader(hdr, capture::paramRecord, 12, index);
+        put(hdr, sizeof(hdr));
+        putValue((uint32_t)id);
+        putValue(value);
+        publish();
+    }
+
+    // Audio thread, for a patch copied in at the end of the block being processed
+    void recordSwappedState(const std::vector<uint8_t> &state)
+    {
+        auto index = blockIndex.load(std::memory_order_relaxed);
+        if (!reserve(capture::recordHeaderSize + state.size()))
+            return;
+        uint8_t hdr[capture::recordHeaderSize];
+        writeHeader(hdr, capture::stateRecord, (uint32_t)state.size(), index);
+        put(hdr, sizeof(hdr));
+        put(state.data(), state.size());
+        publish();
+    }
+
+  private:
+    std::unique_ptr<uint8_t[]> ring;
+    std::atomic<uint64_t> head{0}, tail{0};
+    uint64_t writePos{0};
+
+    std::atomic<uint64_t> blockIndex{0};
+    std::atomic<std::thread::id> processThread{};
+
+    std::vector<std::vector<uint8_t>> pending;
+
+    std::ofstream out;
+    std::thread writerThread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool keepRunning{true};
+
+    static bool keepEvent(const clap_event_header_t *h)
+    {
+        if (h->size > capture::maxEventSize)
+            return false;
+        return !(h->space_id == CLAP_CORE_EVENT_SPACE_ID && h->type == CLAP_EVENT_MIDI_SYSEX);
+    }
+
+    static void clearCookie(uint8_t *e)
+    {
+        auto h = reinterpret_cast<clap_event_header_t *>(e);
+        if (h->space_id != CLAP_CORE_EVENT_SPACE_ID)
+            return;
+        if (h->type == CLAP_EVENT_PARAM_VALUE)
+            reinterpret_cast<clap_event_param_value_t *>(e)->cookie = nullptr;
+        else if (h->type == CLAP_EVENT_PARAM_MOD)
+            reinterpret_cast<clap_event_param_mod_t *>(e)->cookie = nullptr;
+    }
+
+    static uint32_t channelsOf(const clap_audio_buffer_t &port)
+    {
+        // We only ever process 32 bit audio
+        return port.data32 ? port.channel_count : 0;
+    }
+
+    static void writeHeader(uint8_t *into, uint32_t tag, uint32_t payload, uint64_t index)
+    {
+        memcpy(into, &tag, 4);
+        memcpy(into + 4, &payload, 4);
+        memcpy(into + 8, &index, 8);
+    }
+
+    // Room for a whole record, or it is dropped and counted
+    bool reserve(uint64_t bytes)
+    {
+        writePos = head.load(std::memory_order_relaxed);
+        if (writePos + bytes - tail.load(std::memory_order_acquire) > ringSize)
+        {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void put(const void *data, size_t n)
+    {
+        auto src = static_cast<const uint8_t *>(data);
+        auto at = writePos & (ringSize - 1);
+        auto first = std::min(n, ringSize - at);
+        memcpy(ring.get() + at, src, first);
+        if (first < n)
+            memcpy(ring.get(), src + first, n - first);
+        writePos += n;
+    }
+
+    template <typename V> void putValue(V v) { put(&v, sizeof(V)); }
+
+    void publish() { head.store(writePos, std::memory_order_release); }
+
+    void drain()
+    {
+        std::vector<std::vector<uint8_t>> mainRecords;
+        {
+            std::lock_guard<std::mutex> g(mutex);
+            mainRecords.swap(pending);
+        }
+        for (const auto &r : mainRecords)
+            out.write(reinterpret_cast<const char *>(r.data()), (std::streamsize)r.size());
+
+        auto t = tail.load(std::memory_order_relaxed);
+        auto h = head.load(std::memory_order_acquire);
+        while (t != h)
+        {
+            auto at = t & (ringSize - 1);
+            auto n = std::min(h - t, ringSize - at);
+            out.write(reinterpret_cast<const char *>(ring.get() + at), (std::streamsize)n);
+            t += n;
+        }
+        tail.store(t, std::memory_order_release);
+        out.flush();
+    }
+
+    void writerLoop()
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        while (keepRunning)
+        {
+            cv.wait_for(lk, std::chrono::milliseconds(100), [this]() { return !keepRunning; });
+            lk.unlock();
+            drain();
+            lk.lock();
+        }
+    }
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_PROCESS_CAPTURE_H
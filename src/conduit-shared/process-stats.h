@@ -0,0 +1,189 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_PROCESS_STATS_H
+#define CONDUIT_SRC_CONDUIT_SHARED_PROCESS_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "sst/cpputils/ring_buffer.h"
+#include "realtime-guard.h"
+
+namespace sst::conduit::shared
+{
+/*
+ * ProcessStats is the DSP load meter every plugin carries. The audio thread
+ * records the wall time of each process() call into a log2 histogram and adds it,
+ * and the time the block was worth at the sample rate, to running totals. All the
+ * counters only ever grow and each has one writer, so the audio side is plain
+ * relaxed loads and stores and an editor works out load over any interval it
+ * likes from two reads of the totals, and the latency percentiles over one from
+ * two snapshots of the histogram.
+ */
+struct ProcessStats
+{
+    // bucket b counts calls which took [2^b, 2^(b+1)) ns, so 31 is anything over a second
+    static constexpr int nBuckets{32};
+
+    std::atomic<bool> enabled{true};
+
+    std::atomic<uint64_t> histogram[nBuckets]{};
+    std::atomic<uint64_t> calls{0}, busyNs{0}, budgetNs{0};
+
+    std::atomic<uint32_t> fromUiHighWater{0};
+    std::atomic<uint64_t> failedOutputPushes{0};
+
+    static constexpr int bucketFor(uint64_t ns)
+    {
+        return std::clamp((int)std::bit_width(ns) - 1, 0, nBuckets - 1);
+    }
+
+    void record(uint64_t ns, uint64_t blockNs)
+    {
+        auto &h = histogram[bucketFor(ns)];
+        h.store(h.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        busyNs.store(busyNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        budgetNs.store(budgetNs.load(std::memory_order_relaxed) + blockNs,
+                       std::memory_order_relaxed);
+        calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void noteFailedOutputPush() { failedOutputPushes.fetch_add(1, std::memory_order_relaxed); }
+
+    struct Histogram
+    {
+        uint64_t counts[nBuckets]{};
+    };
+    Histogram snapshot() const
+    {
+        Histogram h;
+        for (int i = 0; i < nBuckets; ++i)
+            h.counts[i] = histogram[i].load(std::memory_order_relaxed);
+        return h;
+    }
+
+    // The upper edge, in seconds, of the bucket holding the p-th fraction of the calls
+    // made between two snapshots
+    static double percentileSeconds(double p, const Histogram &from, const Histogram &to)
+    {
+        uint64_t counts[nBuckets], total{0};
+        for (int i = 0; i < nBuckets; ++i)
+        {
+            counts[i] = to.counts[i] - from.counts[i];
+            total += counts[i];
+        }
+        if (total == 0)
+            return 0;
+
+        auto want = (uint64_t)(p * (double)total);
+        uint64_t seen{0};
+        for (int i = 0; i < nBuckets; ++i)
+        {
+            seen += counts[i];
+            if (seen > want)
+                return (double)((uint64_t)1 << (i + 1)) * 1e-9;
+        }
+        return (double)((uint64_t)1 << nBuckets) * 1e-9;
+    }
+};
+
+/*
+ * Put one of these at the top of process() (see ClapBaseClass::processTimingScope)
+ * and it records the call on the way out, whichever return it takes. It is also
+ * the realtime scope for the allocation and lock guard.
+ */
+struct ProcessTimingScope
+{
+    using clock_t = std::chrono::steady_clock;
+
+    realtime_guard::Scope realtimeScope;
+    ProcessStats &stats;
+    uint64_t blockNs{0};
+    bool active{false};
+    clock_t::time_point start;
+
+    ProcessTimingScope(ProcessStats &s, uint32_t frames, double sampleRate) : stats(s)
+    {
+        active = sampleRate > 0 && stats.enabled.load(std::memory_order_relaxed);
+        if (active)
+        {
+            blockNs = (uint64_t)(frames * 1e9 / sampleRate);
+            start = clock_t::now();
+        }
+    }
+    ~ProcessTimingScope()
+    {
+        if (active)
+        {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - start)
+                          .count();
+            stats.record((uint64_t)std::max((int64_t)ns, (int64_t)0), blockNs);
+        }
+    }
+
+    ProcessTimingScope(const ProcessTimingScope &) = delete;
+    ProcessTimingScope &operator=(const ProcessTimingScope &) = delete;
+};
+
+/*
+ * A SimpleRingBuffer which also keeps the deepest it has been. The producer and
+ * consumer each bump their own count, so the producer can see the depth at every
+ * push without touching the buffer internals, and writes the high water mark it
+ * was handed.
+ */
+template <typename T, size_t N>
+struct InstrumentedRingBuffer : sst::cpputils::SimpleRingBuffer<T, N>
+{
+    using base_t = sst::cpputils::SimpleRingBuffer<T, N>;
+    using value_type = T;
+
+    explicit InstrumentedRingBuffer(std::atomic<uint32_t> &hw) : highWater(hw) {}
+
+    decltype(auto) push(const T &t)
+    {
+        auto p = pushed.load(std::memory_order_relaxed) + 1;
+        pushed.store(p, std::memory_order_relaxed);
+        auto depth = (uint32_t)std::min(p - popped.load(std::memory_order_relaxed), (uint64_t)N);
+        if (depth > highWater.load(std::memory_order_relaxed))
+            highWater.store(depth, std::memory_order_relaxed);
+        return base_t::push(t);
+    }
+
+    auto pop()
+    {
+        auto r = base_t::pop();
+        if (r)
+            popped.store(popped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return r;
+    }
+
+  private:
+    std::atomic<uint32_t> &highWater;
+    std::atomic<uint64_t> pushed{0}, popped{0};
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_PROCESS_STATS_H
@@ -0,0 +1,264 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+/*
+ * Only built with CONDUIT_REALTIME_GUARD. See realtime-guard.h.
+ *
+ * The replacements bind inside our own module (the plugins build with hidden
+ * visibility and the benchmarks link us statically), so they see what conduit
+ * code does on the audio thread, not what the host does.
+ */
+
+#include "realtime-guard.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define CONDUIT_RTG_POSIX 1
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_memalign(size_t, size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void __libc_free(void *);
+#endif
+
+namespace sst::conduit::shared::realtime_guard
+{
+thread_local int scopeDepth{0};
+}
+
+namespace
+{
+namespace rtg = sst::conduit::shared::realtime_guard;
+
+thread_local bool inReport{false};
+
+void report(const char *what, size_t size)
+{
+    if (rtg::scopeDepth <= 0 || inReport)
+        return;
+
+    // Anything we call from here may allocate or lock in turn, so stop recursing
+    inReport = true;
+    char msg[128];
+    auto n = snprintf(msg, sizeof(msg), "[conduit] REALTIME VIOLATION: %s (%zu bytes)\n", what,
+                      size);
+#if CONDUIT_RTG_POSIX
+    if (n > 0)
+        (void)!write(2, msg, (size_t)std::min(n, (int)sizeof(msg) - 1));
+    void *frames[48];
+    auto nf = backtrace(frames, 48);
+    backtrace_symbols_fd(frames, nf, 2);
+#else
+    (void)n;
+    fputs(msg, stderr);
+#endif
+    if (getenv("CONDUIT_REALTIME_GUARD_ABORT"))
+        abort();
+    inReport = false;
+}
+
+void *realMalloc(size_t s)
+{
+#if defined(__GLIBC__)
+    return __libc_malloc(s);
+#else
+    return std::malloc(s);
+#endif
+}
+
+void realFree(void *p)
+{
+#if defined(__GLIBC__)
+    __libc_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void *realAlignedMalloc(size_t s, size_t a)
+{
+#if defined(__GLIBC__)
+    return __libc_memalign(a, s);
+#elif defined(_WIN32)
+    return _aligned_malloc(s, a);
+#else
+    void *p{nullptr};
+    if (posix_memalign(&p, std::max(a, sizeof(void *)), s) != 0)
+        return nullptr;
+    return p;
+#endif
+}
+
+void realAlignedFree(void *p)
+{
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    realFree(p);
+#endif
+}
+
+void *guardedNew(size_t s)
+{
+    report("operator new", s);
+    if (s == 0)
+        s = 1;
+    auto p = realMalloc(s);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void guardedDelete(void *p)
+{
+    if (!p)
+        return;
+    report("operator delete", 0);
+    realFree(p);
+}
+
+void *guardedAlignedNew(size_t s, std::align_val_t a)
+{
+    report("aligned operator new", s);
+    if (s == 0)
+        s = 1;
+    auto p = realAlignedMalloc(s, (size_t)a);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void guardedAlignedDelete(void *p)
+{
+    if (!p)
+        return;
+    report("aligned operator delete", 0);
+    realAlignedFree(p);
+}
+} // namespace
+
+void *operator new(size_t s) { return guardedNew(s); }
+void *operator new[](size_t s) { return guardedNew(s); }
+void *operator new(size_t s, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return guardedNew(s);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void *operator new[](size_t s, const std::nothrow_t &t) noexcept { return operator new(s, t); }
+void operator delete(void *p) noexcept { guardedDelete(p); }
+void operator delete[](void *p) noexcept { guardedDelete(p); }
+void operator delete(void *p, size_t) noexcept { guardedDelete(p); }
+void operator delete[](void *p, size_t) noexcept { guardedDelete(p); }
+
+void *operator new(size_t s, std::align_val_t a) { return guardedAlignedNew(s, a); }
+void *operator new[](size_t s, std::align_val_t a) { return guardedAlignedNew(s, a); }
+void *operator new(size_t s, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return guardedAlignedNew(s, a);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+void *operator new[](size_t s, std::align_val_t a, const std::nothrow_t &t) noexcept
+{
+    return operator new(s, a, t);
+}
+void operator delete(void *p, std::align_val_t) noexcept { guardedAlignedDelete(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { guardedAlignedDelete(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { guardedAlignedDelete(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { guardedAlignedDelete(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    guardedAlignedDelete(p);
+}
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    guardedAlignedDelete(p);
+}
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    void *malloc(size_t s)
+    {
+        report("malloc", s);
+        return __libc_malloc(s);
+    }
+    void *calloc(size_t n, size_t s)
+    {
+        report("calloc", n * s);
+        return __libc_calloc(n, s);
+    }
+    void *realloc(void *p, size_t s)
+    {
+        report("realloc", s);
+        return __libc_realloc(p, s);
+    }
+    void free(void *p)
+    {
+        if (p)
+            report("free", 0);
+        __libc_free(p);
+    }
+}
+#endif
+
+#if CONDUIT_RTG_POSIX
+namespace
+{
+using lock_fn_t = int (*)(pthread_mutex_t *);
+// Looked up at load, since dlsym itself allocates
+lock_fn_t realMutexLock = (lock_fn_t)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+} // namespace
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t *m)
+{
+    report("pthread_mutex_lock", 0);
+    if (!realMutexLock)
+        realMutexLock = (lock_fn_t)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    return realMutexLock(m);
+}
+#endif
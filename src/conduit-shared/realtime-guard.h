@@ -0,0 +1,66 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_REALTIME_GUARD_H
+#define CONDUIT_SRC_CONDUIT_SHARED_REALTIME_GUARD_H
+
+/*
+ * With the CONDUIT_REALTIME_GUARD cmake option, realtime-guard.cpp replaces
+ * operator new and delete, aligned forms included, with versions which print a
+ * backtrace to stderr when they are called inside a realtime Scope. So are malloc,
+ * calloc, realloc and free where the C library is glibc, and pthread_mutex_lock on
+ * linux and mac; elsewhere, mac included, those go unchecked. Every process() opens one through
+ * processTimingScope. Set CONDUIT_REALTIME_GUARD_ABORT in the environment to
+ * abort at the first violation instead, which is what you want in CI.
+ *
+ * Without the option Scope and Allow are empty and cost nothing.
+ */
+namespace sst::conduit::shared::realtime_guard
+{
+#if CONDUIT_REALTIME_GUARD
+extern thread_local int scopeDepth;
+
+struct Scope
+{
+    Scope() { scopeDepth++; }
+    ~Scope() { scopeDepth--; }
+};
+
+// For a block we know allocates but have decided to live with for now
+struct Allow
+{
+    int saved;
+    Allow() : saved(scopeDepth) { scopeDepth = 0; }
+    ~Allow() { scopeDepth = saved; }
+};
+#else
+struct Scope
+{
+    Scope() {}
+};
+struct Allow
+{
+    Allow() {}
+};
+#endif
+} // namespace sst::conduit::shared::realtime_guard
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_REALTIME_GUARD_H
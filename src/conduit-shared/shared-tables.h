@@ -0,0 +1,86 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_SHARED_TABLES_H
+#define CONDUIT_SRC_CONDUIT_SHARED_SHARED_TABLES_H
+
+#include <cmath>
+
+#include "sst/basic-blocks/tables/DbToLinearProvider.h"
+#include "sst/basic-blocks/tables/EqualTuningProvider.h"
+#include "sst/basic-blocks/tables/TwoToTheXProvider.h"
+#include "sst/basic-blocks/tables/SincTableProvider.h"
+
+/*
+ * Lookup tables which never change once built. Each is built the first time
+ * something asks for it and then shared, read only, by every instance and voice
+ * in the process, so a host loading dozens of plugins builds them once. Function
+ * statics make that first use thread safe.
+ */
+namespace sst::conduit::shared::tables
+{
+struct Curves
+{
+    sst::basic_blocks::tables::DbToLinearProvider dbToLinear;
+    sst::basic_blocks::tables::EqualTuningProvider equalTuning;
+    sst::basic_blocks::tables::TwoToTheXProvider twoToX;
+
+    Curves()
+    {
+        dbToLinear.init();
+        equalTuning.init();
+        twoToX.init();
+    }
+};
+
+inline const Curves &curves()
+{
+    static const Curves res;
+    return res;
+}
+
+// The interpolation tables behind the SSE sinc delay lines
+inline const sst::basic_blocks::tables::SurgeSincTableProvider &sinc()
+{
+    static const sst::basic_blocks::tables::SurgeSincTableProvider res;
+    return res;
+}
+
+// 12-TET frequency in Hz of each midi key, with A4 (key 69) at 440
+struct MidiKeyFrequencies
+{
+    float hz[128];
+
+    MidiKeyFrequencies()
+    {
+        for (int i = 0; i < 128; ++i)
+            hz[i] = (float)(440.0 * std::pow(2.0, (i - 69.0) / 12.0));
+    }
+};
+
+inline const MidiKeyFrequencies &midiKeyFrequencies()
+{
+    static const MidiKeyFrequencies res;
+    return res;
+}
+} // namespace sst::conduit::shared::tables
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_SHARED_TABLES_H
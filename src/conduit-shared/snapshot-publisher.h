@@ -0,0 +1,112 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_SNAPSHOT_PUBLISHER_H
+#define CONDUIT_SRC_CONDUIT_SHARED_SNAPSHOT_PUBLISHER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include <clap/events.h>
+
+namespace sst::conduit::shared
+{
+/*
+ * SnapshotPublisher is a triple buffer for the telemetry a plugin shows in its
+ * editor (meters, transport, voice counts and so on). The audio thread updates
+ * the plain struct writer() hands back as it goes and calls publish() once per
+ * block, which copies it into the spare buffer and swaps that into the middle. The
+ * editor calls update() or read() and gets the newest whole frame, which stays put
+ * until it asks again, so a display can never show half of one block and half of
+ * the next. Neither side ever waits.
+ *
+ * There is one writer and one reader. The writer may move between threads (the
+ * audio thread while processing, the main thread while inactive) as long as two
+ * threads never write at once. clap keeps process and flush apart, but not process
+ * and the main thread calls such as stateLoad, so work there which changes the
+ * telemetry while active has to be handed to process() to publish.
+ */
+template <typename T> struct SnapshotPublisher
+{
+    static_assert(std::is_copy_assignable_v<T>);
+
+    // Audio thread side
+    T &writer() { return staging; }
+    void publish()
+    {
+        frames[back] = staging;
+        back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Editor side. update() returns true if a newer frame arrived since the last call
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & freshBit))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+    const T &latest() const { return frames[front]; }
+    const T &read()
+    {
+        update();
+        return latest();
+    }
+
+  private:
+    static constexpr uint32_t indexMask{3}, freshBit{4};
+
+    T staging{};
+    std::array<T, 3> frames{};
+    uint32_t back{0}, front{2};
+    std::atomic<uint32_t> middle{1};
+};
+
+/*
+ * The slice of the clap transport our editors show, which several plugins publish
+ * as part of their snapshot.
+ */
+struct TransportSnapshot
+{
+    bool isPlayingOrRecording{false};
+    double tempo{120.0};
+    clap_beattime bar_start{0};
+    int32_t bar_number{0};
+    clap_beattime song_pos_beats{0};
+    uint16_t tsig_num{4}, tsig_denom{4};
+
+    void copyFrom(const clap_event_transport_t *tev)
+    {
+        tempo = tev->tempo;
+        bar_start = tev->bar_start;
+        bar_number = tev->bar_number;
+        song_pos_beats = tev->song_pos_beats;
+        tsig_num = tev->tsig_num;
+        tsig_denom = tev->tsig_denom;
+        isPlayingOrRecording =
+            (tev->flags & CLAP_TRANSPORT_IS_PLAYING) || (tev->flags & CLAP_TRANSPORT_IS_RECORDING);
+    }
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_SNAPSHOT_PUBLISHER_H
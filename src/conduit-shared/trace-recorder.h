@@ -0,0 +1,198 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_CONDUIT_SHARED_TRACE_RECORDER_H
+#define CONDUIT_SRC_CONDUIT_SHARED_TRACE_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "debug-helpers.h"
+
+namespace sst::conduit::shared
+{
+/*
+ * TraceRecorder writes a Chrome trace (load it in chrome://tracing or
+ * ui.perfetto.dev) of named spans on the audio thread. It is off unless the
+ * CONDUIT_TRACE_FILE environment variable is set, in which case each plugin
+ * instance writes <stem>-<plugin>-<n>.json next to that path.
+ *
+ * Spans go into a single producer ring as (name, begin, end) and a writer thread
+ * turns them into JSON a few times a second. If the writer falls behind spans are
+ * dropped and counted, never waited for. Names must be string literals, since only
+ * the pointer is stored.
+ */
+struct TraceRecorder
+{
+    using clock_t = std::chrono::steady_clock;
+
+    struct Span
+    {
+        const char *name;
+        uint64_t beginNs, endNs;
+    };
+    static constexpr size_t ringSize{16384};
+
+    std::atomic<uint64_t> dropped{0};
+
+    ~TraceRecorder() { stop(); }
+
+    bool isActive() const { return ring != nullptr; }
+
+    static uint64_t nowNs()
+    {
+        // Share an epoch across instances so their traces line up
+        static const auto epoch = clock_t::now();
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() -
+                                                                              epoch)
+            .count();
+    }
+
+    void startFromEnvironment(const std::string &pluginId)
+    {
+        auto env = std::getenv("CONDUIT_TRACE_FILE");
+        if (!env || !*env)
+            return;
+
+        static std::atomic<int> instanceCount{0};
+        auto base = std::filesystem::path(env);
+        auto shortId = pluginId.substr(pluginId.find_last_of('.') + 1);
+        auto fn = base.stem().u8string() + "-" + shortId + "-" + std::to_string(++instanceCount) +
+                  ".json";
+        auto path = base.parent_path() / fn;
+
+        out.open(path, std::ios::out | std::ios::trunc);
+        if (!out.is_open())
+        {
+            CNDOUT << "Unable to open trace file " << path.u8string() << std::endl;
+            return;
+        }
+        out << "[\n";
+        out << R"({"name":"process_name","ph":"M","pid":1,"tid":1,"args":{"name":")" << pluginId
+            << "\"}}";
+
+        ring = std::make_unique<Span[]>(ringSize);
+        writerThread = std::thread([this]() { writerLoop(); });
+        CNDOUT << "Tracing to " << path.u8string() << std::endl;
+    }
+
+    void stop()
+    {
+        if (!writerThread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> g(mutex);
+            keepRunning = false;
+        }
+        cv.notify_one();
+        writerThread.join();
+        drain();
+        out << "\n]\n";
+        out.close();
+    }
+
+    // Audio thread only
+    void record(const char *name, uint64_t beginNs, uint64_t endNs)
+    {
+        auto h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= ringSize)
+        {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        ring[h & (ringSize - 1)] = {name, beginNs, endNs};
+        head.store(h + 1, std::memory_order_release);
+    }
+
+  private:
+    std::unique_ptr<Span[]> ring;
+    std::atomic<uint64_t> head{0}, tail{0};
+
+    std::ofstream out;
+    std::thread writerThread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool keepRunning{true};
+
+    void drain()
+    {
+        auto t = tail.load(std::memory_order_relaxed);
+        auto h = head.load(std::memory_order_acquire);
+        for (; t != h; ++t)
+        {
+            const auto &s = ring[t & (ringSize - 1)];
+            // ts and dur are in microseconds
+            out << ",\n"
+                << R"({"name":")" << s.name << R"(","ph":"X","pid":1,"tid":1,"ts":)"
+                << s.beginNs / 1000 << "." << (s.beginNs % 1000) / 100 << R"(,"dur":)"
+                << (s.endNs - s.beginNs) / 1000 << "." << ((s.endNs - s.beginNs) % 1000) / 100
+                << "}";
+        }
+        tail.store(t, std::memory_order_release);
+        out.flush();
+    }
+
+    void writerLoop()
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        while (keepRunning)
+        {
+            cv.wait_for(lk, std::chrono::milliseconds(100), [this]() { return !keepRunning; });
+            drain();
+        }
+    }
+};
+
+/*
+ * A span from construction to destruction. Costs a branch when tracing is off.
+ */
+struct TraceScope
+{
+    TraceRecorder &recorder;
+    const char *name;
+    uint64_t beginNs{0};
+
+    TraceScope(TraceRecorder &r, const char *n) : recorder(r), name(n)
+    {
+        if (recorder.isActive())
+            beginNs = TraceRecorder::nowNs();
+    }
+    ~TraceScope()
+    {
+        if (recorder.isActive())
+            recorder.record(name, beginNs, TraceRecorder::nowNs());
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+};
+} // namespace sst::conduit::shared
+
+#endif // CONDUIT_SRC_CONDUIT_SHARED_TRACE_RECORDER_H
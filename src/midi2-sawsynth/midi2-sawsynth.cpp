@@ -80,9 +80,6 @@ ConduitMIDI2SawSynth::ConduitMIDI2SawSynth(const clap_host *host)
                                     .withFlags(modFlag));
 
     configureParams();
-
-    clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
-    clapJuceShim->setResizable(true);
 }
 
 ConduitMIDI2SawSynth::~ConduitMIDI2SawSynth() {}
@@ -116,6 +113,9 @@ bool ConduitMIDI2SawSynth::notePortsInfo(uint32_t index, bool isInput,
 
 clap_process_status ConduitMIDI2SawSynth::process(const clap_process *process) noexcept
 {
+    auto timing = processTimingScope(process);
+    auto trace = traceScope("process");
+
     auto ev = process->in_events;
     auto sz = ev->size(ev);
 
@@ -216,6 +216,7 @@ clap_process_status ConduitMIDI2SawSynth::process(const clap_process *process) n
         }
     }
 
+    processPatchSwap(process);
     return CLAP_PROCESS_CONTINUE;
 }
 
@@ -181,7 +181,7 @@ struct ConduitMIDI2SawSynth
     void releaseVoice(M2Voice *v, float velocity) {}
     void retriggerVoiceWithNewNoteID(M2Voice *v, int32_t noteid, float velocity)
     {
-        CNDOUT << "retriggerVoice" << std::endl;
+        CNDRTLOG("retriggerVoice");
     }
     void setVoiceMIDIPitchBend(M2Voice *v, uint16_t pb14bit) {}
     void setMIDI1CC(M2Voice *v, int ccid, int val) {}
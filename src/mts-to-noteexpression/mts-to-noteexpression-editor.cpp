@@ -85,7 +85,6 @@ struct ConduitMTSToNoteExpressionEditor : public sst::jucegui::accessibility::Ig
         comms->stopProcessing();
     }
 
-    int lastNoteUpd{-1};
     void onIdle()
     {
         auto cl = uic.dataCopyForUI.mtsClient;
@@ -101,9 +100,9 @@ struct ConduitMTSToNoteExpressionEditor : public sst::jucegui::accessibility::Ig
             scaleName = "";
         }
 
-        if (lastNoteUpd != uic.dataCopyForUI.noteRemainingUpdate)
+        // paint reads latest(), so it only ever sees whole frames
+        if (uic.dataCopyForUI.noteRemaining.update())
         {
-            lastNoteUpd = uic.dataCopyForUI.noteRemainingUpdate;
             repaint();
         }
         if (sn != scaleName)
@@ -130,7 +129,7 @@ struct ConduitMTSToNoteExpressionEditor : public sst::jucegui::accessibility::Ig
             ln("Scale: " + editor->scaleName);
 
             int ct{0};
-            for (auto &c : editor->uic.dataCopyForUI.noteRemaining)
+            for (auto &c : editor->uic.dataCopyForUI.noteRemaining.latest())
             {
                 for (auto &m : c)
                 {
@@ -162,7 +161,7 @@ struct ConduitMTSToNoteExpressionEditor : public sst::jucegui::accessibility::Ig
             };
             int ch{0};
             auto cl = editor->uic.dataCopyForUI.mtsClient;
-            for (auto &c : editor->uic.dataCopyForUI.noteRemaining)
+            for (auto &c : editor->uic.dataCopyForUI.noteRemaining.latest())
             {
                 int nt{0};
                 for (auto &m : c)
@@ -75,9 +75,6 @@ ConduitMTSToNoteExpression::ConduitMTSToNoteExpression(const clap_host *host)
     attachParam(pmReleaseTuning, postNoteRelease);
     attachParam(pmRetuneHeld, retunHeld);
 
-    clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
-    clapJuceShim->setResizable(true);
-
     uiComms.dataCopyForUI.mtsClient = mtsClient;
 }
 
@@ -104,6 +101,9 @@ bool ConduitMTSToNoteExpression::retuneHeldNotes() { return (*retunHeld > 0.5);
 
 clap_process_status ConduitMTSToNoteExpression::process(const clap_process *process) noexcept
 {
+    auto timing = processTimingScope(process);
+    auto trace = traceScope("process");
+
     auto ev = process->in_events;
     auto ov = process->out_events;
     auto sz = ev->size(ev);
@@ -132,7 +132,7 @@ clap_process_status ConduitMTSToNoteExpression::process(const clap_process *proc
 
                     q.value = sclTuning[c][i];
 
-                    ov->try_push(ov, reinterpret_cast<const clap_event_header *>(&q));
+                    pushOutputEvent(ov, reinterpret_cast<const clap_event_header *>(&q));
                 }
             }
         }
@@ -140,10 +140,8 @@ clap_process_status ConduitMTSToNoteExpression::process(const clap_process *proc
 
     if (lastUIUpdate == 0)
     {
-        // if a paint happens through the copy it doesnt matter
-        uiComms.dataCopyForUI.noteRemaining = noteRemaining;
-        // since this will force a paint anyway on next idle
-        uiComms.dataCopyForUI.noteRemainingUpdate++;
+        uiComms.dataCopyForUI.noteRemaining.writer() = noteRemaining;
+        uiComms.dataCopyForUI.noteRemaining.publish();
     }
     lastUIUpdate = (lastUIUpdate + 1) & 15;
 
@@ -163,7 +161,7 @@ clap_process_status ConduitMTSToNoteExpression::process(const clap_process *proc
         case CLAP_EVENT_MIDI2:
         case CLAP_EVENT_MIDI_SYSEX:
         case CLAP_EVENT_NOTE_CHOKE:
-            ov->try_push(ov, evt);
+            pushOutputEvent(ov, evt);
             break;
         case CLAP_EVENT_NOTE_ON:
         {
@@ -192,8 +190,8 @@ clap_process_status ConduitMTSToNoteExpression::process(const clap_process *proc
             }
             q.value = sclTuning[nevt->channel][nevt->key];
 
-            ov->try_push(ov, evt);
-            ov->try_push(ov, &(q.header));
+            pushOutputEvent(ov, evt);
+            pushOutputEvent(ov, &(q.header));
         }
         break;
         case CLAP_EVENT_NOTE_OFF:
@@ -204,7 +202,7 @@ clap_process_status ConduitMTSToNoteExpression::process(const clap_process *proc
             assert(nevt->key >= 0);
             assert(nevt->key < 128);
             noteRemaining[nevt->channel][nevt->key] = *postNoteRelease;
-            ov->try_push(ov, evt);
+            pushOutputEvent(ov, evt);
         }
         break;
         case CLAP_EVENT_NOTE_EXPRESSION:
@@ -223,7 +221,7 @@ clap_process_status ConduitMTSToNoteExpression::process(const clap_process *proc
                 oevt.value += sclTuning[nevt->channel][nevt->key];
             }
 
-            ov->try_push(ov, &oevt.header);
+            pushOutputEvent(ov, &oevt.header);
         }
         break;
         }
@@ -239,6 +237,7 @@ clap_process_status ConduitMTSToNoteExpression::process(const clap_process *proc
                     n = 0.f;
             }
 
+    processPatchSwap(process);
     return CLAP_PROCESS_CONTINUE;
 }
 
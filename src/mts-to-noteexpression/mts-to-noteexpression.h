@@ -52,9 +52,9 @@ struct ConduitMTSToNoteExpressionConfig
         std::atomic<int32_t> updateCount{0};
         MTSClient *mtsClient{nullptr};
 
-        std::array<std::array<float, 128>, 16>
-            noteRemaining; // -1 means still held, otherwise its the time
-        std::atomic<int32_t> noteRemainingUpdate{0};
+        // -1 means still held, otherwise its the time. Published every 16 blocks.
+        using noteRemaining_t = std::array<std::array<float, 128>, 16>;
+        sst::conduit::shared::SnapshotPublisher<noteRemaining_t> noteRemaining;
     };
 
     static const clap_plugin_descriptor *getDescription();
@@ -155,7 +155,7 @@ ConduitPolymetricDelay::ConduitPolymetricDelay(const clap_host *host)
 
     configureParams();
 
-    attachParam(pmDryLevel, dryLev);
+    enableParamRamp(pmDryLevel, dryLevRamp);
 
     for (int i = 0; i < nTaps; ++i)
     {
@@ -180,8 +180,7 @@ ConduitPolymetricDelay::ConduitPolymetricDelay(const clap_host *host)
     recalcTaps();
     recalcModulators();
 
-    clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
-    clapJuceShim->setResizable(false);
+    editorResizable = false;
 }
 
 ConduitPolymetricDelay::~ConduitPolymetricDelay() {}
@@ -215,86 +214,29 @@ bool ConduitPolymetricDelay::audioPortsInfo(uint32_t index, bool isInput,
     return false;
 }
 
-clap_process_status ConduitPolymetricDelay::process(const clap_process *process) noexcept
+void ConduitPolymetricDelay::renderSamplesKernel(RenderState &rs, uint32_t start, uint32_t end)
 {
-    while (!uiComms.fromUiQ.empty())
-    {
-        auto r = *uiComms.fromUiQ.pop();
-        generateOutputMessagesFromUI(r, process->out_events);
-        if (r.type == FromUI::ADJUST_VALUE)
-        {
-            doValueUpdate(r.id, r.value);
-            specificParamChange(r.id, r.value);
-        }
-    }
-    refreshUIIfNeeded();
-
-    if (process->audio_outputs_count <= 0)
-        return CLAP_PROCESS_SLEEP;
-    if (process->audio_inputs_count <= 0)
-        return CLAP_PROCESS_SLEEP;
-
-    float **out = process->audio_outputs[0].data32;
-    auto ochans = process->audio_outputs->channel_count;
-
-    float **const in = process->audio_inputs[0].data32;
-    auto ichans = process->audio_inputs->channel_count;
-
-    auto chans = std::min(ochans, ichans);
-    if (chans < 2)
-        return CLAP_PROCESS_SLEEP;
-
-    auto ev = process->in_events;
-    auto sz = ev->size(ev);
-
-    // This pointer is the sentinel to our next event which we advance once an event is processed
-    const clap_event_header_t *nextEvent{nullptr};
-    uint32_t nextEventIndex{0};
-    if (sz != 0)
-    {
-        nextEvent = ev->get(ev, nextEventIndex);
-    }
-
-    if (process->transport)
-    {
-        handleInboundEvent((const clap_event_header *)(process->transport));
-    }
-
-    float inMx[2]{0, 0}, outMx[2]{0, 0}, tapMx[nTaps][2]{};
-    bool active[nTaps];
-    for (int i = 0; i < nTaps; ++i)
-    {
-        active[i] = *(tapData[i].active) > 0.5;
-    }
-
-    for (auto i = 0U; i < process->frames_count; ++i)
+    for (auto i = start; i < end; ++i)
     {
-        while (nextEvent && nextEvent->time == i)
-        {
-            handleInboundEvent(nextEvent);
-            nextEventIndex++;
-            if (nextEventIndex >= sz)
-                nextEvent = nullptr;
-            else
-                nextEvent = ev->get(ev, nextEventIndex);
-        }
-
         if (slowProcess >= blockSize)
         {
+            advanceLags(rs.lagOffset);
+            rs.lagOffset = 0;
+
             slowProcess = 0;
-            inVU.process(inMx[0], inMx[1]);
-            outVU.process(outMx[0], outMx[1]);
-            inMx[0] = 0;
-            inMx[1] = 0;
-            outMx[0] = 0;
-            outMx[1] = 0;
+            inVU.process(rs.inMx[0], rs.inMx[1]);
+            outVU.process(rs.outMx[0], rs.outMx[1]);
+            rs.inMx[0] = 0;
+            rs.inMx[1] = 0;
+            rs.outMx[0] = 0;
+            rs.outMx[1] = 0;
 
             for (int t = 0; t < nTaps; ++t)
             {
-                tapOutVU[t].process(tapMx[t][0], tapMx[t][1]);
+                tapOutVU[t].process(rs.tapMx[t][0], rs.tapMx[t][1]);
 
-                tapMx[t][0] = 0;
-                tapMx[t][1] = 0;
+                rs.tapMx[t][0] = 0;
+                rs.tapMx[t][1] = 0;
 
                 // Recalc pan laws
                 sst::basic_blocks::dsp::pan_laws::stereoEqualPower((*(tapData[t].pan) + 1) * 0.5,
@@ -309,19 +251,21 @@ clap_process_status ConduitPolymetricDelay::process(const clap_process *process)
         float totalTapFB[2]{};
         for (int tap = 0; tap < nTaps; ++tap)
         {
-            if (!active[tap])
+            if (!rs.active[tap])
                 continue;
 
-            auto tl = tapData[tap].level.v;
+            const auto &td = tapData[tap];
+            auto tl = lagValueAt(td.level, rs.lagOffset);
             tl = tl * tl * tl;
-            auto ftl = tapData[tap].fblev.v;
+            auto ftl = lagValueAt(td.fblev, rs.lagOffset);
             ftl = ftl * ftl * ftl;
-            auto cftl = tapData[tap].crossfblev.v;
+            auto cftl = lagValueAt(td.crossfblev, rs.lagOffset);
             cftl = cftl * cftl * cftl;
 
+            auto md = lagValueAt(td.moddepth, rs.lagOffset);
+
             tapData[tap].modulator.step();
-            auto tt = baseTapSamples[tap] *
-                      (1 + modDepthScale * tapData[tap].moddepth.v * tapData[tap].modulator.u);
+            auto tt = baseTapSamples[tap] * (1 + modDepthScale * md * tapData[tap].modulator.u);
 
             auto smpL = delayLine[0].read(tt);
             auto smpR = delayLine[1].read(tt);
@@ -335,8 +279,8 @@ clap_process_status ConduitPolymetricDelay::process(const clap_process *process)
             hp[tap].process_sample(dL, dR, dL, dR);
             lp[tap].process_sample(dL, dR, dL, dR);
 
-            tapMx[tap][0] = std::max(tapMx[tap][0], std::abs(dL));
-            tapMx[tap][1] = std::max(tapMx[tap][1], std::abs(dR));
+            rs.tapMx[tap][0] = std::max(rs.tapMx[tap][0], std::abs(dL));
+            rs.tapMx[tap][1] = std::max(rs.tapMx[tap][1], std::abs(dR));
 
             totalTapOut[0] += dL;
             totalTapOut[1] += dR;
@@ -345,30 +289,117 @@ clap_process_status ConduitPolymetricDelay::process(const clap_process *process)
             totalTapFB[1] += smpR * ftl + smpL * cftl;
         }
 
-        auto dl = (*dryLev);
+        auto dl = dryLevels[i];
         dl = dl * dl * dl;
-        for (auto c = 0U; c < chans; ++c)
+        for (auto c = 0U; c < rs.chans; ++c)
         {
-            out[c][i] = in[c][i] * dl + totalTapOut[c];
+            rs.out[c][i] = rs.in[c][i] * dl + totalTapOut[c];
 
-            delayLine[c].write(in[c][i] + totalTapFB[c]);
-            inMx[c] = std::max(inMx[c], std::abs(in[c][i]));
-            outMx[c] = std::max(outMx[c], std::abs(out[c][i]));
+            delayLine[c].write(rs.in[c][i] + totalTapFB[c]);
+            rs.inMx[c] = std::max(rs.inMx[c], std::abs(rs.in[c][i]));
+            rs.outMx[c] = std::max(rs.outMx[c], std::abs(rs.out[c][i]));
         }
 
-        processLags();
+        rs.lagOffset++;
     }
+}
 
+CONDUIT_TARGET_AVX2 void ConduitPolymetricDelay::renderSamplesAVX2(RenderState &rs, uint32_t start,
+                                                                   uint32_t end)
+{
+    renderSamplesKernel(rs, start, end);
+}
+
+void ConduitPolymetricDelay::renderSamples(RenderState &rs, uint32_t start, uint32_t end)
+{
+    if (shared::cpu::useAVX2())
+        return renderSamplesAVX2(rs, start, end);
+    renderSamplesKernel(rs, start, end);
+}
+
+clap_process_status ConduitPolymetricDelay::process(const clap_process *process) noexcept
+{
+    auto timing = processTimingScope(process);
+    auto trace = traceScope("process");
+
+    while (!uiComms.fromUiQ.empty())
+    {
+        auto r = *uiComms.fromUiQ.pop();
+        generateOutputMessagesFromUI(r, process->out_events);
+        if (r.type == FromUI::ADJUST_VALUE)
+        {
+            doValueUpdate(r.id, r.value);
+            specificParamChange(r.id, r.value);
+            if (processCapture.isActive())
+                processCapture.recordParamValue(r.id, r.value);
+        }
+    }
+    refreshUIIfNeeded();
+
+    if (process->audio_outputs_count <= 0)
+        return CLAP_PROCESS_SLEEP;
+    if (process->audio_inputs_count <= 0)
+        return CLAP_PROCESS_SLEEP;
+
+    float **out = process->audio_outputs[0].data32;
+    auto ochans = process->audio_outputs->channel_count;
+
+    float **const in = process->audio_inputs[0].data32;
+    auto ichans = process->audio_inputs->channel_count;
+
+    auto chans = std::min(ochans, ichans);
+    if (chans < 2)
+        return CLAP_PROCESS_SLEEP;
+
+    if (process->frames_count > dryLevels.size())
+        return CLAP_PROCESS_ERROR;
+
+    beginParamRamps(process);
+    renderParamRamp(dryLevRamp, 0, process->frames_count, dryLevels.data());
+
+    if (process->transport)
+    {
+        handleInboundEvent((const clap_event_header *)(process->transport));
+    }
+
+    RenderState rs;
+    rs.in = in;
+    rs.out = out;
+    rs.chans = chans;
+    for (int i = 0; i < nTaps; ++i)
+    {
+        rs.active[i] = *(tapData[i].active) > 0.5;
+    }
+
+    processInEventChunks(
+        process,
+        [&](auto *evt) {
+            advanceLags(rs.lagOffset);
+            rs.lagOffset = 0;
+            auto ts = traceScope("event");
+            handleInboundEvent(evt);
+        },
+        [&](uint32_t start, uint32_t end) {
+            auto ts = traceScope("render");
+            renderSamples(rs, start, end);
+        });
+
+    advanceLags(rs.lagOffset);
+
+    auto &tel = uiComms.dataCopyForUI.telemetry.writer();
     for (int c = 0; c < 2; ++c)
     {
-        uiComms.dataCopyForUI.inVu[c] = inVU.vu_peak[c];
-        uiComms.dataCopyForUI.outVu[c] = outVU.vu_peak[c];
+        tel.inVu[c] = inVU.vu_peak[c];
+        tel.outVu[c] = outVU.vu_peak[c];
         for (int t = 0; t < nTaps; ++t)
         {
-            uiComms.dataCopyForUI.tapVu[t][c] = tapOutVU[t].vu_peak[c];
+            tel.tapVu[t][c] = tapOutVU[t].vu_peak[c];
         }
     }
+    uiComms.dataCopyForUI.telemetry.publish();
 
+    endParamRamps();
+    processPatchSwap(process);
     return CLAP_PROCESS_CONTINUE;
 }
 
@@ -406,15 +437,7 @@ void ConduitPolymetricDelay::handleInboundEvent(const clap_event_header_t *evt)
             recalcTaps();
         }
 
-        uiComms.dataCopyForUI.tempo = tev->tempo;
-        uiComms.dataCopyForUI.bar_start = tev->bar_start;
-        uiComms.dataCopyForUI.bar_number = tev->bar_number;
-        uiComms.dataCopyForUI.song_pos_beats = tev->song_pos_beats;
-        uiComms.dataCopyForUI.tsig_num = tev->tsig_num;
-        uiComms.dataCopyForUI.tsig_denom = tev->tsig_denom;
-
-        uiComms.dataCopyForUI.isPlayingOrRecording =
-            (tev->flags & CLAP_TRANSPORT_IS_PLAYING) || (tev->flags & CLAP_TRANSPORT_IS_RECORDING);
+        uiComms.dataCopyForUI.telemetry.writer().transport.copyFrom(tev);
     }
     break;
     }
@@ -460,9 +483,9 @@ void ConduitPolymetricDelay::recalcModulators()
     for (int i = 0; i < nTaps; ++i)
     {
         static constexpr double mf0{8.17579891564};
-        tapData[i].modulator.setRate(2.0 * M_PI *
-                                     note_to_pitch_ignoring_tuning(tapData[i].modrate.v + 69) *
-                                     mf0 * dsamplerate_inv);
+        auto rate = lagValue(tapData[i].modrate);
+        tapData[i].modulator.setRate(2.0 * M_PI * note_to_pitch_ignoring_tuning(rate + 69) * mf0 *
+                                     dsamplerate_inv);
     }
 }
 
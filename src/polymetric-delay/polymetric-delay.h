@@ -36,11 +36,11 @@
 #include "sst/basic-blocks/dsp/VUPeak.h"
 #include "sst/basic-blocks/dsp/SSESincDelayLine.h"
 #include "sst/basic-blocks/dsp/QuadratureOscillators.h"
-#include "sst/basic-blocks/tables/SincTableProvider.h"
 
 #include "sst/filters/BiquadFilter.h"
 
 #include "conduit-shared/clap-base-class.h"
+#include "conduit-shared/cpu-dispatch.h"
 
 namespace sst::conduit::polymetric_delay
 {
@@ -58,15 +58,13 @@ struct ConduitPolymetricDelayConfig
         std::atomic<uint32_t> updateCount{0};
         std::atomic<bool> isProcessing{false};
 
-        std::atomic<bool> isPlayingOrRecording;
-        std::atomic<double> tempo;
-        std::atomic<clap_beattime> bar_start;
-        std::atomic<int32_t> bar_number;
-        std::atomic<clap_beattime> song_pos_beats;
-
-        std::atomic<uint16_t> tsig_num, tsig_denom;
-
-        std::atomic<float> inVu[2], outVu[2], tapVu[4][2];
+        // Published once per block; see snapshot-publisher.h
+        struct Telemetry
+        {
+            sst::conduit::shared::TransportSnapshot transport;
+            float inVu[2]{}, outVu[2]{}, tapVu[4][2]{};
+        };
+        sst::conduit::shared::SnapshotPublisher<Telemetry> telemetry;
     };
 
     static const clap_plugin_descriptor *getDescription();
@@ -84,6 +82,8 @@ struct ConduitPolymetricDelay
         recalcTaps();
         recalcModulators();
 
+        dryLevels.resize(maxFrameCount);
+
         inVU.setSampleRate(sr);
         outVU.setSampleRate(sr);
         for (auto &t : tapOutVU)
@@ -171,9 +171,9 @@ struct ConduitPolymetricDelay
     // For now our strategy is to just have honkin big delay lines
     // but we want to make these adapt with max time going forward
     // This is enough for about 20 seconds of delay at 48khz
-    sst::basic_blocks::tables::SurgeSincTableProvider st{};
     static constexpr uint32_t dlSize{1 << 20};
-    sst::basic_blocks::dsp::SSESincDelayLine<dlSize> delayLine[2]{st, st};
+    sst::basic_blocks::dsp::SSESincDelayLine<dlSize> delayLine[2]{shared::tables::sinc(),
+                                                                  shared::tables::sinc()};
 
   protected:
     std::unique_ptr<juce::Component> createEditor() override;
@@ -184,14 +184,16 @@ struct ConduitPolymetricDelay
     void specificParamChange(clap_id id, float val);
 
   public:
-    float *dryLev;
+    // The dry level follows host automation sample accurately, one ramp per block
+    RampHandle dryLevRamp;
+    std::vector<float> dryLevels;
 
     struct TapData
     {
         float *ntaps, *mbeats, *active;
 
         float *locut, *hicut, *pan;
-        lag_t level, fblev, crossfblev, moddepth, modrate;
+        LagHandle level, fblev, crossfblev, moddepth, modrate;
 
         sst::basic_blocks::dsp::QuadratureOscillator<float> modulator;
     } tapData[nTaps];
@@ -211,6 +213,21 @@ struct ConduitPolymetricDelay
     }
 
     std::array<sst::filters::Biquad::BiquadFilter<ConduitPolymetricDelay, blockSize>, nTaps> hp, lp;
+
+    // What the sample loop in process carries from one event chunk to the next
+    struct RenderState
+    {
+        float **in{nullptr}, **out{nullptr};
+        uint32_t chans{0};
+        bool active[nTaps]{};
+        float inMx[2]{}, outMx[2]{}, tapMx[nTaps][2]{};
+        // How far into the current lag sub-block we are. See LagBank.
+        uint32_t lagOffset{0};
+    };
+    // The taps, the delay lines and the meters for [start, end), as cpu-dispatch.h shows
+    void renderSamples(RenderState &rs, uint32_t start, uint32_t end);
+    CONDUIT_TARGET_AVX2 void renderSamplesAVX2(RenderState &rs, uint32_t start, uint32_t end);
+    CONDUIT_FORCE_INLINE void renderSamplesKernel(RenderState &rs, uint32_t start, uint32_t end);
 };
 } // namespace sst::conduit::polymetric_delay
 
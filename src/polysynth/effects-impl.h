@@ -75,8 +75,7 @@ struct PhaserConfig : SharedConfig
     static int presetIndex(const BaseClass *bc)
     {
         auto s = bc->synth;
-        auto pn = s->paramToValue[ConduitPolysynth::pmModFXPreset];
-        return (int)std::round(*pn);
+        return (int)std::round(s->paramValue(s->audioParams.modFXPreset));
     }
 
     static float temposyncRatio(GlobalStorage *g, EffectStorage *, int) { return 1.; }
@@ -85,12 +84,12 @@ struct PhaserConfig : SharedConfig
     {
         if (idx == PhaserFX::ph_mix)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXMix]);
+            return bc->synth->paramValue(bc->synth->audioParams.modFXMix);
         }
 
         if (idx == PhaserFX::ph_mod_rate)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXRate]);
+            return bc->synth->paramValue(bc->synth->audioParams.modFXRate);
         }
         return presets[presetIndex(bc)][idx];
     }
@@ -112,18 +111,17 @@ struct FlangerConfig : SharedConfig
     static int presetIndex(const BaseClass *bc)
     {
         auto s = bc->synth;
-        auto pn = s->paramToValue[ConduitPolysynth::pmModFXPreset];
-        return (int)std::round(*pn);
+        return (int)std::round(s->paramValue(s->audioParams.modFXPreset));
     }
     static float floatValueAt(const BaseClass *bc, const ValueStorage *, int idx)
     {
         if (idx == FlangerFX::fl_mix)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXMix]);
+            return bc->synth->paramValue(bc->synth->audioParams.modFXMix);
         }
         if (idx == FlangerFX::fl_rate)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmModFXRate]);
+            return bc->synth->paramValue(bc->synth->audioParams.modFXRate);
         }
         return presets[presetIndex(bc)][idx];
     }
@@ -146,19 +144,18 @@ struct Reverb1Config : SharedConfig
     static int presetIndex(const BaseClass *bc)
     {
         auto s = bc->synth;
-        auto pn = s->paramToValue[ConduitPolysynth::pmRevFXPreset];
-        return (int)std::round(*pn);
+        return (int)std::round(s->paramValue(s->audioParams.revFXPreset));
     }
 
     static float floatValueAt(const BaseClass *bc, const ValueStorage *, int idx)
     {
         if (idx == ReverbFX::rev1_mix)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmRevFXMix]);
+            return bc->synth->paramValue(bc->synth->audioParams.revFXMix);
         }
         if (idx == ReverbFX::rev1_decaytime)
         {
-            return *(bc->synth->paramToValue[ConduitPolysynth::pmRevFXTime]);
+            return bc->synth->paramValue(bc->synth->audioParams.revFXTime);
         }
         return presets[presetIndex(bc)][idx];
     }
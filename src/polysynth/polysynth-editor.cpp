@@ -375,16 +375,12 @@ struct StatusPanel : jcmp::NamedPanel
                 g.drawText(s, bx, juce::Justification::centredRight);
                 bx = bx.translated(0, bx.getHeight());
             };
+            auto &tr = panel->uic.dataCopyForUI.telemetry.read().transport;
             d("Debug Info");
-            d(fmt::format("tempo={} play={}", panel->uic.dataCopyForUI.tempo.load(),
-                          panel->uic.dataCopyForUI.isPlayingOrRecording.load()));
-            d(fmt::format("tsig={}/{}", panel->uic.dataCopyForUI.tsig_num.load(),
-                          panel->uic.dataCopyForUI.tsig_denom.load()));
-            d(fmt::format("song pos={}", panel->uic.dataCopyForUI.song_pos_beats.load()));
-            d(fmt::format("bar start={} num={}", panel->uic.dataCopyForUI.bar_start.load(),
-                          panel->uic.dataCopyForUI.bar_number.load())
-
-            );
+            d(fmt::format("tempo={} play={}", tr.tempo, tr.isPlayingOrRecording));
+            d(fmt::format("tsig={}/{}", tr.tsig_num, tr.tsig_denom));
+            d(fmt::format("song pos={}", tr.song_pos_beats));
+            d(fmt::format("bar start={} num={}", tr.bar_start, tr.bar_number));
         }
     };
 
@@ -880,7 +876,7 @@ void ModMatrixPanel::ModMatrixRow::resendData()
 
 void ModMatrixPanel::ModMatrixRow::updateFromDataIfNeeded()
 {
-    int32_t v = uic.dataCopyForUI.rescanMatrix;
+    int32_t v = uic.dataCopyForUI.telemetry.read().matrixVersion;
     if (v != lastDataUpdate)
     {
         updateFromDataCopy();
@@ -890,7 +886,7 @@ void ModMatrixPanel::ModMatrixRow::updateFromDataIfNeeded()
 
 void ModMatrixPanel::ModMatrixRow::updateFromDataCopy()
 {
-    auto &dc = uic.dataCopyForUI.modMatrixCopy[row];
+    auto &dc = uic.dataCopyForUI.telemetry.read().modMatrixCopy[row];
     s1value = std::get<0>(dc);
     s2value = std::get<1>(dc);
     tgtvalue = std::get<2>(dc);
@@ -1039,8 +1035,9 @@ StatusPanel::~StatusPanel() { ed.comms->removeIdleHandler("status"); }
 
 void StatusPanel::updateStatus()
 {
-    vuMeter->setLevels(uic.dataCopyForUI.mainVU[0], uic.dataCopyForUI.mainVU[1]);
-    voiceCountLabel->setText("Voices : " + std::to_string(uic.dataCopyForUI.polyphony));
+    auto &tel = uic.dataCopyForUI.telemetry.read();
+    vuMeter->setLevels(tel.mainVU[0], tel.mainVU[1]);
+    voiceCountLabel->setText("Voices : " + std::to_string(tel.polyphony));
     repaint();
 }
 
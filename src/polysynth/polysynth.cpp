@@ -552,33 +552,32 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
 
     configureParams();
 
-    terminatedVoices.reserve(max_voices * 4);
-
-    clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
-    clapJuceShim->setResizable(true);
-
-    mtsClient = MTS_RegisterClient();
-
-    if (mtsClient)
-    {
-        if (MTS_HasMaster(mtsClient))
-        {
-            CNDOUT << "MTS: Client registered with " << MTS_GetScaleName(mtsClient) << std::endl;
-        }
-        else
-        {
-            CNDOUT << "MTS: Client present without available source" << std::endl;
-        }
-    }
-
-    phaserFX = std::make_unique<PhaserFX>(this, this, this);
-    phaserFX->initialize();
-
-    flangerFX = std::make_unique<FlangerFX>(this, this, this);
-    flangerFX->initialize();
+    auto &ap = audioParams;
+    ap.sawActive = paramHandle(pmSawActive);
+    ap.sawUnisonCount = paramHandle(pmSawUnisonCount);
+    ap.pulseActive = paramHandle(pmPWActive);
+    ap.sinActive = paramHandle(pmSinActive);
+    ap.noiseActive = paramHandle(pmNoiseActive);
+    ap.svfActive = paramHandle(pmSVFActive);
+    ap.svfMode = paramHandle(pmSVFFilterMode);
+    ap.wsActive = paramHandle(pmWSActive);
+    ap.wsMode = paramHandle(pmWSMode);
+    ap.lpfActive = paramHandle(pmLPFActive);
+    ap.lpfMode = paramHandle(pmLPFFilterMode);
+    ap.filterRouting = paramHandle(pmFilterRouting);
+    for (int i = 0; i < n_lfos; ++i)
+        ap.lfoShape[i] = paramHandle(pmLFOShape + i * offPmLFO2);
+    ap.modFXActive = paramHandle(pmModFXActive);
+    ap.modFXType = paramHandle(pmModFXType);
+    ap.modFXPreset = paramHandle(pmModFXPreset);
+    ap.modFXRate = paramHandle(pmModFXRate);
+    ap.modFXMix = paramHandle(pmModFXMix);
+    ap.revFXActive = paramHandle(pmRevFXActive);
+    ap.revFXPreset = paramHandle(pmRevFXPreset);
+    ap.revFXTime = paramHandle(pmRevFXTime);
+    ap.revFXMix = paramHandle(pmRevFXMix);
 
-    reverbFX = std::make_unique<ReverbFX>(this, this, this);
-    reverbFX->initialize();
+    terminatedVoices.reserve(max_voices * 4);
 
     for (auto &v : voices)
     {
@@ -586,7 +585,7 @@ ConduitPolysynth::ConduitPolysynth(const clap_host *host)
     }
 
     patch.extension.initialize();
-    uiComms.dataCopyForUI.populateMatrixView(patch.extension.modMatrixConfig);
+    uiComms.dataCopyForUI.publishMatrixView(patch.extension.modMatrixConfig);
 }
 ConduitPolysynth::~ConduitPolysynth()
 {
@@ -603,8 +602,46 @@ bool ConduitPolysynth::activate(double sampleRate, uint32_t minFrameCount,
                                 uint32_t maxFrameCount) noexcept
 {
     setSampleRate(sampleRate);
+
+    /*
+     * The MTS client and the effects wait for the first activate, since hosts scanning
+     * plugins or loading a project construct plenty of instances which never run.
+     */
+    if (!mtsClient)
+    {
+        mtsClient = MTS_RegisterClient();
+
+        if (mtsClient)
+        {
+            if (MTS_HasMaster(mtsClient))
+            {
+                CNDOUT << "MTS: Client registered with " << MTS_GetScaleName(mtsClient)
+                       << std::endl;
+            }
+            else
+            {
+                CNDOUT << "MTS: Client present without available source" << std::endl;
+            }
+        }
+    }
+
+    if (!phaserFX)
+    {
+        phaserFX = std::make_unique<PhaserFX>(this, this, this);
+        phaserFX->initialize();
+
+        flangerFX = std::make_unique<FlangerFX>(this, this, this);
+        flangerFX->initialize();
+
+        reverbFX = std::make_unique<ReverbFX>(this, this, this);
+        reverbFX->initialize();
+    }
+
     for (auto &v : voices)
+    {
+        v.mtsClient = mtsClient;
         v.setSampleRate(sampleRate * 2); // run voices oversampled
+    }
     phaserFX->onSampleRateChanged();
     flangerFX->onSampleRateChanged();
     reverbFX->onSampleRateChanged();
@@ -666,6 +703,9 @@ bool ConduitPolysynth::notePortsInfo(uint32_t index, bool isInput,
  */
 clap_process_status ConduitPolysynth::process(const clap_process *process) noexcept
 {
+    auto timing = processTimingScope(process);
+    auto trace = traceScope("process");
+
     // If I have no outputs, do nothing
     if (process->audio_outputs_count <= 0)
         return CLAP_PROCESS_SLEEP;
@@ -676,9 +716,7 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
      * The UI can send us gesture begin/end events which translate in to a
      * `clap_event_param_gesture` or value adjustments.
      */
-    auto ct = handleEventsFromUIQueue(process->out_events);
-    if (ct)
-        pushParamsToVoices();
+    handleEventsFromUIQueue(process->out_events);
 
     /*
      * Stage 2: Create the AUDIO output and process events
@@ -686,7 +724,8 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
      * CLAP has a single inbound event loop where every event is time stamped with
      * a sample id. This means the process loop can easily interleave note and parameter
      * and other events with audio generation. Here we do everything completely sample accurately
-     * by maintaining a pointer to the 'nextEvent' which we check at every sample.
+     * by splitting the block into event free runs with processInEventChunks, handling the
+     * events at the start of each run and copying out whole runs of rendered audio.
      */
     float **out = process->audio_outputs[0].data32;
     auto chans = process->audio_outputs->channel_count;
@@ -695,79 +734,66 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
         return CLAP_PROCESS_SLEEP;
     }
 
-    auto ev = process->in_events;
-    auto sz = ev->size(ev);
-
-    // This pointer is the sentinel to our next event which we advance once an event is processed
-    const clap_event_header_t *nextEvent{nullptr};
-    uint32_t nextEventIndex{0};
-    if (sz != 0)
-    {
-        nextEvent = ev->get(ev, nextEventIndex);
-    }
-
     if (process->transport)
     {
-        auto tev = process->transport;
-
-        uiComms.dataCopyForUI.tempo = tev->tempo;
-        uiComms.dataCopyForUI.bar_start = tev->bar_start;
-        uiComms.dataCopyForUI.bar_number = tev->bar_number;
-        uiComms.dataCopyForUI.song_pos_beats = tev->song_pos_beats;
-        uiComms.dataCopyForUI.tsig_num = tev->tsig_num;
-        uiComms.dataCopyForUI.tsig_denom = tev->tsig_denom;
-
-        uiComms.dataCopyForUI.isPlayingOrRecording =
-            (tev->flags & CLAP_TRANSPORT_IS_PLAYING) || (tev->flags & CLAP_TRANSPORT_IS_RECORDING);
+        uiComms.dataCopyForUI.telemetry.writer().transport.copyFrom(process->transport);
     }
 
-    bool modActive = *paramToValue[pmModFXActive] > 0.5;
-    bool revActive = *paramToValue[pmRevFXActive] > 0.5;
-    bool usePhaser = *paramToValue[pmModFXType] < 0.5;
+    bool modActive = paramValue(audioParams.modFXActive) > 0.5;
+    bool revActive = paramValue(audioParams.revFXActive) > 0.5;
+    bool usePhaser = paramValue(audioParams.modFXType) < 0.5;
 
-    for (auto i = 0U; i < process->frames_count; ++i)
-    {
-        // Do I have an event to process. Note that multiple events
-        // can occur on the same sample, hence 'while' not 'if'
-        while (nextEvent && nextEvent->time == i)
-        {
+    processInEventChunks(
+        process,
+        [this](auto *evt) {
             // handleInboundEvent is a separate function which adjusts the state based
             // on event type. We segregate it for clarity but you really should read it!
-            handleInboundEvent(nextEvent);
-            nextEventIndex++;
-            if (nextEventIndex >= sz)
-                nextEvent = nullptr;
-            else
-                nextEvent = ev->get(ev, nextEventIndex);
-        }
-
-        if (blockPos == 0)
-        {
-            renderVoices();
-            if (modActive)
+            auto ts = traceScope("event");
+            handleInboundEvent(evt);
+        },
+        [&](uint32_t start, uint32_t end) {
+            auto i = start;
+            while (i < end)
             {
-                if (usePhaser)
-                {
-                    phaserFX->processBlock(output[0], output[1]);
-                }
-                else
+                if (blockPos == 0)
                 {
-                    flangerFX->processBlock(output[0], output[1]);
+                    {
+                        auto ts = traceScope("renderVoices");
+                        renderVoices();
+                    }
+                    if (modActive)
+                    {
+                        if (usePhaser)
+                        {
+                            auto ts = traceScope("phaser");
+                            phaserFX->processBlock(output[0], output[1]);
+                        }
+                        else
+                        {
+                            auto ts = traceScope("flanger");
+                            flangerFX->processBlock(output[0], output[1]);
+                        }
+                    }
+                    if (revActive)
+                    {
+                        auto ts = traceScope("reverb");
+                        reverbFX->processBlock(output[0], output[1]);
+                    }
+                    auto ts = traceScope("vu");
+                    mainVU.process<PolysynthVoice::blockSize>(output[0], output[1]);
+                    auto &tel = uiComms.dataCopyForUI.telemetry.writer();
+                    tel.mainVU[0] = mainVU.vu_peak[0];
+                    tel.mainVU[1] = mainVU.vu_peak[1];
                 }
-            }
-            if (revActive)
-            {
-                reverbFX->processBlock(output[0], output[1]);
-            }
-            mainVU.process<PolysynthVoice::blockSize>(output[0], output[1]);
-            uiComms.dataCopyForUI.mainVU[0] = mainVU.vu_peak[0];
-            uiComms.dataCopyForUI.mainVU[1] = mainVU.vu_peak[1];
-        }
-        out[0][i] = output[0][blockPos];
-        out[1][i] = output[1][blockPos];
 
-        blockPos = (blockPos + 1) & (PolysynthVoice::blockSize - 1);
-    }
+                auto n = std::min(end - i, (uint32_t)(PolysynthVoice::blockSize - blockPos));
+                memcpy(out[0] + i, output[0] + blockPos, n * sizeof(float));
+                memcpy(out[1] + i, output[1] + blockPos, n * sizeof(float));
+
+                i += n;
+                blockPos = (blockPos + n) & (PolysynthVoice::blockSize - 1);
+            }
+        });
 
     /*
      * Stage 3 is to inform the host of our terminated voices.
@@ -780,12 +806,15 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
      * is here through natural state transition to NEWLY_OFF and the second is in
      * handleNoteOn when we steal a voice.
      */
+    auto noteEndTrace = traceScope("noteEnds");
     for (auto &v : voices)
     {
         if (v.active && !v.isPlaying())
         {
             terminatedVoices.emplace_back(v.portid, v.channel, v.key, v.note_id);
             v.active = false;
+            if (v.group)
+                v.group->leave(v);
             voiceEndCallback(&v);
         }
     }
@@ -807,16 +836,18 @@ clap_process_status ConduitPolysynth::process(const clap_process *process) noexc
         evt.note_id = note_id;
         evt.velocity = 0.0;
 
-        ov->try_push(ov, &(evt.header));
+        pushOutputEvent(ov, &(evt.header));
 
         uiComms.dataCopyForUI.updateCount++;
-        uiComms.dataCopyForUI.polyphony--;
+        uiComms.dataCopyForUI.telemetry.writer().polyphony--;
     }
     terminatedVoices.clear();
 
-    // We should have gotten all the events
-    assert(!nextEvent);
+    if (matrixRepublishPending.exchange(false, std::memory_order_acq_rel))
+        uiComms.dataCopyForUI.populateMatrixView(patch.extension.modMatrixConfig);
+    uiComms.dataCopyForUI.telemetry.publish();
 
+    processPatchSwap(process);
     return CLAP_PROCESS_CONTINUE;
 }
 
@@ -826,8 +857,20 @@ void ConduitPolysynth::renderVoices()
     for (auto &v : voices)
     {
         if (v.isPlaying())
-        {
             v.processBlock();
+    }
+
+    for (auto &g : voiceGroups)
+    {
+        if (g.count)
+            g.process();
+    }
+
+    for (auto &v : voices)
+    {
+        if (v.isPlaying())
+        {
+            v.finishBlock();
             sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSizeOS>(
                 v.outputOS[0], outputOS[0]);
             sst::basic_blocks::mechanics::accumulate_from_to<PolysynthVoice::blockSizeOS>(
@@ -849,7 +892,6 @@ void ConduitPolysynth::handleInboundEvent(const clap_event_header_t *evt)
 {
     if (handleParamBaseEvents(evt))
     {
-        pushParamsToVoices();
         return;
     }
 
@@ -898,7 +940,6 @@ void ConduitPolysynth::handleInboundEvent(const clap_event_header_t *evt)
     {
         auto v = reinterpret_cast<const clap_event_param_value *>(evt);
         updateParamInPatch(v);
-        pushParamsToVoices();
     }
     break;
     /*
@@ -937,15 +978,6 @@ PolysynthVoice *ConduitPolysynth::initializeVoice(uint16_t port, uint16_t channe
         if (!v.active)
         {
             activateVoice(v, port, channel, key, noteId, velocity);
-
-            if (clapJuceShim->isEditorAttached())
-            {
-                auto r = ToUI();
-                r.type = ToUI::MIDI_NOTE_ON;
-                r.id = (uint32_t)key;
-                uiComms.toUiQ.push(r);
-            }
-
             return &v;
         }
     }
@@ -958,14 +990,6 @@ void ConduitPolysynth::releaseVoice(PolysynthVoice *sdv, float velocity)
     {
         sdv->releaseVelocity = velocity;
         sdv->release();
-
-        if (clapJuceShim->isEditorAttached())
-        {
-            auto r = ToUI();
-            r.type = ToUI::MIDI_NOTE_OFF;
-            r.id = (uint32_t)sdv->key;
-            uiComms.toUiQ.push(r);
-        }
     }
 }
 
@@ -973,7 +997,32 @@ void ConduitPolysynth::activateVoice(PolysynthVoice &v, int port_index, int chan
                                      int noteid, double velocity)
 {
     v.start(port_index, channel, key, noteid, velocity);
-    uiComms.dataCopyForUI.polyphony++;
+    if (v.anyFilterStepActive)
+        joinVoiceGroup(v);
+    uiComms.dataCopyForUI.telemetry.writer().polyphony++;
+}
+
+/*
+ * Pair the voice with one already sounding through the same filters if we can, so both
+ * halves of the group's registers do work; otherwise it starts a group of its own.
+ */
+void ConduitPolysynth::joinVoiceGroup(PolysynthVoice &v)
+{
+    auto config = VoiceGroup::configFor(v);
+    VoiceGroup *target{nullptr};
+    for (auto &g : voiceGroups)
+    {
+        if (g.count > 0 && g.accepts(config))
+        {
+            target = &g;
+            break;
+        }
+        if (!target && g.count == 0)
+            target = &g;
+    }
+    assert(target);
+    target->join(v, config);
+    v.recalcFilter();
 }
 
 /*
@@ -993,22 +1042,26 @@ void ConduitPolysynth::paramsFlush(const clap_input_events *in,
         handleInboundEvent(nextEvent);
     }
 
-    auto ct = handleEventsFromUIQueue(out);
-
-    if (ct)
-        pushParamsToVoices();
+    handleEventsFromUIQueue(out);
 
     // We will never generate a note end event with processing active, and we have no midi
     // output, so we are done.
 }
 
-void ConduitPolysynth::pushParamsToVoices() {}
-
 void ConduitPolysynthConfig::PatchExtension::initialize()
 {
     modMatrixConfig = std::make_unique<ModMatrixConfig>();
 }
 
+void ConduitPolysynthConfig::PatchExtension::assignInPlace(const PatchExtension &other)
+{
+    if (!modMatrixConfig)
+        initialize();
+    if (other.modMatrixConfig)
+        modMatrixConfig->routings = other.modMatrixConfig->routings;
+    mpeMode = other.mpeMode;
+}
+
 void ConduitPolysynth::handleSpecializedFromUI(const FromUI &r)
 {
     auto &smw = r.specializedMessage;
@@ -1021,7 +1074,8 @@ void ConduitPolysynth::handleSpecializedFromUI(const FromUI &r)
         rt.via = (ModMatrixConfig::Sources)sm.s2;
         rt.target = (ConduitPolysynth::paramIds)sm.tgt;
         rt.depth = sm.depth;
-        uiComms.dataCopyForUI.populateMatrixView(patch.extension.modMatrixConfig);
+        // We are the telemetry writer here: in process, or in flush while inactive
+        uiComms.dataCopyForUI.publishMatrixView(patch.extension.modMatrixConfig);
     }
     else if (std::holds_alternative<smt::MPEConfig>(smw.payload))
     {
@@ -1030,20 +1084,28 @@ void ConduitPolysynth::handleSpecializedFromUI(const FromUI &r)
     }
     else
     {
-        CNDOUT << "WARNING: Unhandled specialized variant" << std::endl;
+        CNDRTLOG("WARNING: Unhandled specialized variant");
     }
 }
 
 void ConduitPolysynthConfig::DataCopyForUI::populateMatrixView(
     const std::unique_ptr<ModMatrixConfig> &c)
 {
+    auto &tel = telemetry.writer();
     int i{0};
     for (auto row : c->routings)
     {
-        modMatrixCopy[i] = {row.source, row.via, row.target, row.depth};
+        tel.modMatrixCopy[i] = {row.source, row.via, row.target, row.depth};
         i++;
     }
-    rescanMatrix++;
+    tel.matrixVersion++;
+}
+
+void ConduitPolysynthConfig::DataCopyForUI::publishMatrixView(
+    const std::unique_ptr<ModMatrixConfig> &c)
+{
+    populateMatrixView(c);
+    telemetry.publish();
 }
 
 bool ConduitPolysynthConfig::PatchExtension::toXml(TiXmlElement &root)
@@ -1103,9 +1165,54 @@ bool ConduitPolysynthConfig::PatchExtension::fromXml(TiXmlElement *root)
     return true;
 }
 
+bool ConduitPolysynthConfig::PatchExtension::toBinary(
+    sst::conduit::shared::binary_state::Writer &w) const
+{
+    w.u32(modMatrixConfig->routings.size());
+    for (const auto &el : modMatrixConfig->routings)
+    {
+        w.i32(el.source);
+        w.i32(el.via);
+        w.i32(el.target);
+        w.f32(el.depth);
+    }
+    return true;
+}
+
+bool ConduitPolysynthConfig::PatchExtension::fromBinary(
+    sst::conduit::shared::binary_state::Reader &rd)
+{
+    auto n = rd.u32();
+    for (auto idx = 0U; idx < n && rd.ok; ++idx)
+    {
+        auto s = rd.i32();
+        auto v = rd.i32();
+        auto t = rd.i32();
+        auto d = rd.f32();
+
+        if (rd.ok && idx < modMatrixConfig->routings.size())
+        {
+            auto &rto = modMatrixConfig->routings[idx];
+            rto.source = (ModMatrixConfig::Sources)s;
+            rto.via = (ModMatrixConfig::Sources)v;
+            rto.target = (ConduitPolysynth::paramIds)t;
+            rto.depth = d;
+        }
+    }
+    return rd.ok;
+}
+
 void ConduitPolysynth::onStateRestored()
 {
-    uiComms.dataCopyForUI.populateMatrixView(patch.extension.modMatrixConfig);
+    /*
+     * A host state load lands here on the main thread, which may be while process()
+     * is publishing, and the publisher takes one writer at a time. So while active we
+     * only flag it and the next process() publishes; inactive, nothing else writes.
+     */
+    if (isActive())
+        matrixRepublishPending.store(true, std::memory_order_release);
+    else
+        uiComms.dataCopyForUI.publishMatrixView(patch.extension.modMatrixConfig);
 }
 
 } // namespace sst::conduit::polysynth
@@ -51,17 +51,12 @@
 
 #include "conduit-shared/clap-base-class.h"
 #include "voice.h"
+#include "voice-group.h"
 
 struct MTSClient;
 
 namespace sst::conduit::polysynth
 {
-/*
- * This static (defined in the cpp file) allows us to present a name, feature set,
- * url etc... and is consumed by clap-saw-demo-pluginentry.cpp
- */
-static constexpr int nParams{72};
-
 struct ModMatrixConfig;
 
 struct ConduitPolysynthConfig
@@ -77,8 +72,14 @@ struct ConduitPolysynthConfig
         void initialize();
         std::unique_ptr<ModMatrixConfig> modMatrixConfig;
 
+        // Sounding voices point into modMatrixConfig, so a loaded patch copies its routings
+        // into it rather than replacing it
+        void assignInPlace(const PatchExtension &other);
+
         bool toXml(TiXmlElement &);
         bool fromXml(TiXmlElement *);
+        bool toBinary(sst::conduit::shared::binary_state::Writer &) const;
+        bool fromBinary(sst::conduit::shared::binary_state::Reader &);
 
         bool mpeMode{false};
     };
@@ -86,24 +87,27 @@ struct ConduitPolysynthConfig
     {
         std::atomic<uint32_t> updateCount{0};
         std::atomic<bool> isProcessing{false};
-        std::atomic<int> polyphony{0};
-
-        std::atomic<float> mainVU[2];
 
         // s1, s2, target, depth
         using modMessage = std::tuple<int32_t, int32_t, int32_t, float>;
-        std::array<modMessage, 8> modMatrixCopy;
-        std::atomic<uint32_t> rescanMatrix{0};
 
-        std::atomic<bool> isPlayingOrRecording;
-        std::atomic<double> tempo;
-        std::atomic<clap_beattime> bar_start;
-        std::atomic<int32_t> bar_number;
-        std::atomic<clap_beattime> song_pos_beats;
+        // Published once per block; see snapshot-publisher.h
+        struct Telemetry
+        {
+            int polyphony{0};
+            float mainVU[2]{0.f, 0.f};
+
+            std::array<modMessage, 8> modMatrixCopy{};
+            uint32_t matrixVersion{0};
 
-        std::atomic<uint16_t> tsig_num, tsig_denom;
+            sst::conduit::shared::TransportSnapshot transport;
+        };
+        sst::conduit::shared::SnapshotPublisher<Telemetry> telemetry;
 
+        // Copies the matrix into the telemetry writer; publishMatrixView publishes it too.
+        // Only the thread which is the telemetry writer may call either.
         void populateMatrixView(const std::unique_ptr<ModMatrixConfig> &);
+        void publishMatrixView(const std::unique_ptr<ModMatrixConfig> &);
     };
 
     static const clap_plugin_descriptor *getDescription();
@@ -243,6 +247,20 @@ struct ConduitPolysynth
     static constexpr int offPmLFO2{100};
     static constexpr int n_lfos{2};
 
+    /*
+     * The parameters we read directly on the audio thread (at voice start and in
+     * the FX configs) rather than through an attached pointer. These are resolved
+     * to slots once in the constructor.
+     */
+    struct AudioThreadParams
+    {
+        ParamHandle sawActive, sawUnisonCount, pulseActive, sinActive, noiseActive;
+        ParamHandle svfActive, svfMode, wsActive, wsMode, lpfActive, lpfMode, filterRouting;
+        ParamHandle lfoShape[n_lfos];
+        ParamHandle modFXActive, modFXType, modFXPreset, modFXRate, modFXMix;
+        ParamHandle revFXActive, revFXPreset, revFXTime, revFXMix;
+    } audioParams;
+
   public:
     /*
      * Many CLAP plugins will want input and output audio and note ports, although
@@ -282,7 +300,6 @@ struct ConduitPolysynth
      */
     clap_process_status process(const clap_process *process) noexcept override;
     void handleInboundEvent(const clap_event_header_t *evt);
-    void pushParamsToVoices();
     void activateVoice(PolysynthVoice &v, int port_index, int channel, int key, int noteid,
                        double velocity);
 
@@ -317,6 +334,8 @@ struct ConduitPolysynth
     std::uniform_real_distribution<float> urd;
 
     void onStateRestored() override;
+    // A state restored while active leaves the matrix telemetry for process() to publish
+    std::atomic<bool> matrixRepublishPending{false};
 
   protected:
     std::unique_ptr<juce::Component> createEditor() override;
@@ -361,7 +380,7 @@ struct ConduitPolysynth
     void releaseVoice(PolysynthVoice *v, float velocity);
     void retriggerVoiceWithNewNoteID(PolysynthVoice *v, int32_t noteid, float velocity)
     {
-        CNDOUT << "retriggerVoice" << std::endl;
+        CNDRTLOG("retriggerVoice");
     }
 
     void setVoiceMIDIPitchBend(PolysynthVoice *v, uint16_t pb14bit)
@@ -415,6 +434,9 @@ struct ConduitPolysynth
     voiceManager_t voiceManager;
 
     std::array<PolysynthVoice, max_voices> voices;
+    // One per voice is always enough, so joining a group never fails
+    std::array<VoiceGroup, max_voices> voiceGroups;
+    void joinVoiceGroup(PolysynthVoice &v);
     std::vector<std::tuple<int, int, int, int>> terminatedVoices; // that's PCK ID
 };
 
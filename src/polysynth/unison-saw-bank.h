@@ -0,0 +1,149 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_POLYSYNTH_UNISON_SAW_BANK_H
+#define CONDUIT_SRC_POLYSYNTH_UNISON_SAW_BANK_H
+
+#include <algorithm>
+
+#include "conduit-shared/sse-include.h"
+
+namespace sst::conduit::polysynth
+{
+/*
+ * Up to maxVoices DPW saws, four unison voices a register, mixed to stereo through a
+ * per voice left and right gain. Each step advances every phase in a register at once
+ * and returns the panned sum.
+ *
+ * The saw is the differentiated parabolic wave: with the phase p in [-1, 1) moving 2 dp
+ * a sample, out = (p^2 - q^2) / 4 dp where q is the previous phase. p^2 - q^2 is taken as
+ * (p - q)(p + q), and p - q is known exactly - 2 dp, less 2 on a wrap - so this keeps its
+ * precision in float at low frequencies where the difference of squares would not.
+ *
+ * Like the BlockInterpSmoothingStrategy oscillators it replaced, dp glides linearly to
+ * each new frequency over glideSteps steps, then holds there. As with those after a
+ * retrigger, every phase starts at zero and the first frequency is jumped to.
+ */
+template <int maxVoices, int glideSteps> struct UnisonSawBank
+{
+    static constexpr int nRegs{(maxVoices + 3) / 4};
+
+    __m128 phase[nRegs], dPhase[nRegs], dPhaseStep[nRegs];
+    __m128 gainL[nRegs], gainR[nRegs];
+    int voices{1}, regs{1}, glideLeft{0};
+    bool primed{false};
+
+    // Restarts every phase at zero for count voices, each silent until setGains
+    void retrigger(int count)
+    {
+        voices = std::clamp(count, 1, maxVoices);
+        regs = (voices + 3) / 4;
+        for (int g = 0; g < nRegs; ++g)
+        {
+            phase[g] = _mm_setzero_ps();
+            dPhase[g] = _mm_set1_ps(minDPhase);
+            dPhaseStep[g] = _mm_setzero_ps();
+            gainL[g] = _mm_setzero_ps();
+            gainR[g] = _mm_setzero_ps();
+        }
+        glideLeft = 0;
+        primed = false;
+    }
+
+    void setGains(const float *l, const float *r)
+    {
+        float gl alignas(16)[nRegs * 4]{}, gr alignas(16)[nRegs * 4]{};
+        std::copy(l, l + voices, gl);
+        std::copy(r, r + voices, gr);
+        for (int g = 0; g < nRegs; ++g)
+        {
+            gainL[g] = _mm_load_ps(gl + 4 * g);
+            gainR[g] = _mm_load_ps(gr + 4 * g);
+        }
+    }
+
+    // hz holds one frequency per voice. The first call after a retrigger jumps rather than glides.
+    void setFrequencies(const float *hz, float srInv)
+    {
+        float dp alignas(16)[nRegs * 4];
+        for (int i = 0; i < nRegs * 4; ++i)
+            dp[i] = i < voices ? std::clamp(hz[i] * srInv, minDPhase, maxDPhase) : minDPhase;
+
+        const auto glideInv = _mm_set1_ps(1.f / glideSteps);
+        for (int g = 0; g < regs; ++g)
+        {
+            auto target = _mm_load_ps(dp + 4 * g);
+            if (primed)
+            {
+                dPhaseStep[g] = _mm_mul_ps(_mm_sub_ps(target, dPhase[g]), glideInv);
+            }
+            else
+            {
+                dPhase[g] = target;
+                dPhaseStep[g] = _mm_setzero_ps();
+            }
+        }
+        glideLeft = primed ? glideSteps : 0;
+        primed = true;
+    }
+
+    inline void step(float &L, float &R)
+    {
+        const auto one = _mm_set1_ps(1.f), two = _mm_set1_ps(2.f), quarter = _mm_set1_ps(0.25f);
+        auto accL = _mm_setzero_ps(), accR = _mm_setzero_ps();
+        for (int g = 0; g < regs; ++g)
+        {
+            auto q = phase[g];
+            auto dp2 = _mm_add_ps(dPhase[g], dPhase[g]);
+            auto p = _mm_add_ps(q, dp2);
+            auto wrap = _mm_and_ps(_mm_cmpgt_ps(p, one), two);
+            p = _mm_sub_ps(p, wrap);
+
+            auto pq = _mm_mul_ps(_mm_sub_ps(dp2, wrap), _mm_add_ps(p, q));
+            auto out = _mm_div_ps(_mm_mul_ps(pq, quarter), dPhase[g]);
+
+            phase[g] = p;
+            if (glideLeft)
+                dPhase[g] = _mm_add_ps(dPhase[g], dPhaseStep[g]);
+
+            accL = _mm_add_ps(accL, _mm_mul_ps(out, gainL[g]));
+            accR = _mm_add_ps(accR, _mm_mul_ps(out, gainR[g]));
+        }
+
+        if (glideLeft)
+            glideLeft--;
+
+        // [l0 + l2, r0 + r2, l1 + l3, r1 + r3] then l and r in the low two lanes. No hadd in SSE2.
+        auto h = _mm_add_ps(_mm_unpacklo_ps(accL, accR), _mm_unpackhi_ps(accL, accR));
+        h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+        float res alignas(16)[4];
+        _mm_store_ps(res, h);
+        L = res[0];
+        R = res[1];
+    }
+
+  private:
+    // Keeps dp away from zero, where the divide fails, and below nyquist, where a phase
+    // could pass 1 by more than one wrap
+    static constexpr float minDPhase{1e-7f}, maxDPhase{0.49f};
+};
+} // namespace sst::conduit::polysynth
+#endif
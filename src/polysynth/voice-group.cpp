@@ -0,0 +1,254 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#include "voice-group.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace sst::conduit::polysynth
+{
+VoiceGroup::Config VoiceGroup::configFor(const PolysynthVoice &v)
+{
+    Config c;
+    c.routing = v.filterRouting;
+    c.lpfActive = v.lpfActive;
+    if (v.lpfActive)
+    {
+        c.lpfType = v.qfType;
+        c.lpfSubType = v.qfSubType;
+    }
+    c.wsActive = v.wsActive;
+    if (v.wsActive)
+        c.wsType = v.wsType;
+    c.svfActive = v.svfActive;
+    if (v.svfActive)
+        c.svfMode = v.svfMode;
+    return c;
+}
+
+void VoiceGroup::join(PolysynthVoice &v, const Config &c)
+{
+    assert(accepts(c));
+    if (count == 0)
+    {
+        config = c;
+
+        qfPtr = c.lpfActive ? sst::filters::GetCompensatedQFPtrFilterUnit<true>(c.lpfType,
+                                                                                 c.lpfSubType)
+                            : nullptr;
+        wsPtr = c.wsActive ? sst::waveshapers::GetQuadWaveshaper(c.wsType) : nullptr;
+        kernel = kernelFor(c);
+
+        qfState = sst::filters::QuadFilterUnitState{};
+        for (int i = 0; i < 4; ++i)
+        {
+            qfState.DB[i] = delayBufferData[i];
+            qfState.active[i] = 0;
+            qfState.WP[i] = 0;
+        }
+        wsState = sst::waveshapers::QuadWaveshaperState{};
+        svf.init();
+        feedbackSignal = _mm_setzero_ps();
+        memset(in, 0, sizeof(in));
+    }
+
+    int slot{0};
+    while (voices[slot])
+        slot++;
+    voices[slot] = &v;
+    count++;
+    v.group = this;
+    v.groupSlot = slot;
+
+    // Everything below touches only this voice's two lanes, since the other slot may be playing
+    auto lane = slot * 2;
+    for (auto &r : qfState.R)
+        setLanes(r, lane, 2, 0.f);
+    for (int i = lane; i < lane + 2; ++i)
+    {
+        if (c.lpfActive)
+            memset(delayBufferData[i], 0, sizeof(delayBufferData[i]));
+        qfState.active[i] = (int)0xffffffff;
+        qfState.WP[i] = 0;
+    }
+
+    if (c.wsActive)
+    {
+        float R[sst::waveshapers::n_waveshaper_registers];
+        sst::waveshapers::initializeWaveshaperRegister(c.wsType, R);
+        for (int i = 0; i < sst::waveshapers::n_waveshaper_registers; ++i)
+            setLanes(wsState.R[i], lane, 2, R[i]);
+    }
+    setLanes(wsState.init, lane, 2, 0.f);
+
+    setLanes(svf.ic1eq, lane, 2, 0.f);
+    setLanes(svf.ic2eq, lane, 2, 0.f);
+    setLanes(feedbackSignal, lane, 2, 0.f);
+}
+
+void VoiceGroup::leave(PolysynthVoice &v)
+{
+    assert(v.group == this && voices[v.groupSlot] == &v);
+    auto lane = v.groupSlot * 2;
+    voices[v.groupSlot] = nullptr;
+    count--;
+
+    // The free lanes still run with their partner, so quieten them rather than leave a
+    // stale block looping round the feedback path
+    for (auto s = 0; s < blockSizeOS; ++s)
+    {
+        in[s][lane] = 0.f;
+        in[s][lane + 1] = 0.f;
+        feedback[s][lane] = 0.f;
+        feedback[s][lane + 1] = 0.f;
+    }
+    qfState.active[lane] = 0;
+    qfState.active[lane + 1] = 0;
+
+    v.group = nullptr;
+    v.groupSlot = -1;
+}
+
+void VoiceGroup::load(PolysynthVoice &v)
+{
+    auto lane = v.groupSlot * 2;
+    for (auto s = 0; s < blockSizeOS; ++s)
+    {
+        in[s][lane] = v.outputOS[0][s];
+        in[s][lane + 1] = v.outputOS[1][s];
+        drive[s][lane] = drive[s][lane + 1] = v.wsDrive_lipol.v;
+        bias[s][lane] = bias[s][lane + 1] = v.wsBias_lipol.v;
+        feedback[s][lane] = feedback[s][lane + 1] = v.filterFeedback_lipol.v;
+        v.wsDrive_lipol.process();
+        v.wsBias_lipol.process();
+        v.filterFeedback_lipol.process();
+    }
+}
+
+void VoiceGroup::unload(PolysynthVoice &v)
+{
+    auto lane = v.groupSlot * 2;
+    for (auto s = 0; s < blockSizeOS; ++s)
+    {
+        v.outputOS[0][s] = out[s][lane];
+        v.outputOS[1][s] = out[s][lane + 1];
+    }
+}
+
+VoiceGroup::Kernel VoiceGroup::kernelFor(const Config &c)
+{
+    switch (c.routing)
+    {
+    case PolysynthVoice::LowWSMulti:
+        return kernelForRouting<PolysynthVoice::LowWSMulti>(c);
+    case PolysynthVoice::MultiWSLow:
+        return kernelForRouting<PolysynthVoice::MultiWSLow>(c);
+    case PolysynthVoice::WSLowMulti:
+        return kernelForRouting<PolysynthVoice::WSLowMulti>(c);
+    case PolysynthVoice::LowMultiWS:
+        return kernelForRouting<PolysynthVoice::LowMultiWS>(c);
+    case PolysynthVoice::WSPar:
+        return kernelForRouting<PolysynthVoice::WSPar>(c);
+    case PolysynthVoice::ParWS:
+        return kernelForRouting<PolysynthVoice::ParWS>(c);
+    }
+    return kernelForRouting<PolysynthVoice::LowWSMulti>(c);
+}
+
+template <int Routing> VoiceGroup::Kernel VoiceGroup::kernelForRouting(const Config &c)
+{
+    if (!c.svfActive)
+        return kernelForStages<Routing, svfOff>(c);
+
+    switch (c.svfMode)
+    {
+    case SVF::LP:
+        return kernelForStages<Routing, SVF::LP>(c);
+    case SVF::HP:
+        return kernelForStages<Routing, SVF::HP>(c);
+    case SVF::BP:
+        return kernelForStages<Routing, SVF::BP>(c);
+    case SVF::NOTCH:
+        return kernelForStages<Routing, SVF::NOTCH>(c);
+    case SVF::PEAK:
+        return kernelForStages<Routing, SVF::PEAK>(c);
+    case SVF::ALL:
+        return kernelForStages<Routing, SVF::ALL>(c);
+    }
+    return kernelForStages<Routing, svfOff>(c);
+}
+
+template <int Routing, int SVFMode> VoiceGroup::Kernel VoiceGroup::kernelForStages(const Config &c)
+{
+    if (c.lpfActive)
+        return c.wsActive ? processKernel<Routing, SVFMode, true, true>
+                          : processKernel<Routing, SVFMode, true, false>;
+    return c.wsActive ? processKernel<Routing, SVFMode, false, true>
+                      : processKernel<Routing, SVFMode, false, false>;
+}
+
+template <int Routing, int SVFMode, bool LPF, bool WS> void VoiceGroup::processKernel(VoiceGroup &g)
+{
+    const auto half = _mm_set1_ps(0.5f);
+    for (auto s = 0; s < blockSizeOS; ++s)
+    {
+        auto output = _mm_add_ps(_mm_load_ps(g.in[s]), g.feedbackSignal);
+
+        // The bias is zero when the waveshaper is off, so skipping it with the stage is exact
+        auto low = [&g](__m128 x) {
+            if constexpr (LPF)
+                return g.qfPtr(&g.qfState, x);
+            return x;
+        };
+        auto ws = [&g, s](__m128 x) {
+            if constexpr (WS)
+                return g.wsPtr(&g.wsState, _mm_add_ps(x, _mm_load_ps(g.bias[s])),
+                               _mm_load_ps(g.drive[s]));
+            return x;
+        };
+        auto multi = [&g](__m128 x) {
+            if constexpr (SVFMode != svfOff)
+                return SVF::stepSSE<SVFMode>(g.svf, x);
+            return x;
+        };
+
+        if constexpr (Routing == PolysynthVoice::LowWSMulti)
+            output = multi(ws(low(output)));
+        if constexpr (Routing == PolysynthVoice::MultiWSLow)
+            output = low(ws(multi(output)));
+        if constexpr (Routing == PolysynthVoice::WSLowMulti)
+            output = multi(low(ws(output)));
+        if constexpr (Routing == PolysynthVoice::LowMultiWS)
+            output = ws(multi(low(output)));
+        if constexpr (Routing == PolysynthVoice::WSPar)
+        {
+            output = ws(output);
+            output = _mm_mul_ps(half, _mm_add_ps(low(output), multi(output)));
+        }
+        if constexpr (Routing == PolysynthVoice::ParWS)
+            output = ws(_mm_mul_ps(half, _mm_add_ps(low(output), multi(output))));
+
+        g.feedbackSignal = _mm_mul_ps(output, _mm_load_ps(g.feedback[s]));
+        _mm_store_ps(g.out[s], output);
+    }
+}
+} // namespace sst::conduit::polysynth
@@ -0,0 +1,114 @@
+/*
+ * Conduit - a project highlighting CLAP-first development
+ *           and exercising the surge synth team libraries.
+ *
+ * Copyright 2023-2024 Paul Walker and authors in github
+ *
+ * This file you are viewing now is released under the
+ * MIT license as described in LICENSE.md
+ *
+ * The assembled program which results from compiling this
+ * project has GPL3 dependencies, so if you distribute
+ * a binary, the combined work would be a GPL3 product.
+ *
+ * Roughly, that means you are welcome to copy the code and
+ * ideas in the src/ directory, but perhaps not code from elsewhere
+ * if you are closed source or non-GPL3. And if you do copy this code
+ * you will need to replace some of the dependencies. Please see
+ * the discussion in README.md for further information on what this may
+ * mean for you.
+ */
+
+#ifndef CONDUIT_SRC_POLYSYNTH_VOICE_GROUP_H
+#define CONDUIT_SRC_POLYSYNTH_VOICE_GROUP_H
+
+#include "conduit-shared/sse-include.h"
+
+#include "sst/filters.h"
+#include "sst/waveshapers.h"
+
+#include "voice.h"
+
+namespace sst::conduit::polysynth
+{
+/*
+ * A VoiceGroup runs the filter stage only - LPF, waveshaper and SVF in the routing
+ * order - for two stereo voices at once, so each register is full: voice A's L and R
+ * in lanes 0 and 1 and voice B's in lanes 2 and 3. This is how QuadFilterUnitState and
+ * the quad waveshapers are meant to be driven. The unison pan comes before the filter,
+ * so a voice is stereo by then and two voices fill the one register a quad filter
+ * state holds. The oscillators, envelopes and LFOs still run per voice, scalar.
+ *
+ * Only voices with the same filter configuration can share a group, since the filter
+ * and waveshaper functions are per register and not per lane; the coefficients, state
+ * and delay lines are per lane.
+ *
+ * A voice writes its pre filter signal into its lanes at the end of
+ * PolysynthVoice::processBlock, the synth runs every non empty group, and
+ * PolysynthVoice::finishBlock reads the result back.
+ *
+ * The per sample loop is a template over the routing, the SVF mode and which of the LPF
+ * and waveshaper are on, and join binds the one instance the config needs. The SVF step
+ * inlines into it and stages which are off compile away; the LPF and waveshaper are
+ * still called through the library's pointers, since their types are runtime choices.
+ */
+struct VoiceGroup
+{
+    static constexpr int maxVoices{2};
+    static constexpr int blockSizeOS{PolysynthVoice::blockSizeOS};
+    using SVF = PolysynthVoice::StereoSimperSVF;
+
+    struct Config
+    {
+        int routing{0};
+        bool lpfActive{false}, wsActive{false}, svfActive{false};
+        sst::filters::FilterType lpfType{sst::filters::FilterType::fut_none};
+        sst::filters::FilterSubType lpfSubType{(sst::filters::FilterSubType)0};
+        sst::waveshapers::WaveshaperType wsType{sst::waveshapers::WaveshaperType::wst_none};
+        int svfMode{SVF::LP};
+
+        bool operator==(const Config &) const = default;
+    };
+    // Stages which are off don't split groups, so their types are left at the defaults
+    static Config configFor(const PolysynthVoice &v);
+
+    Config config;
+    PolysynthVoice *voices[maxVoices]{};
+    int count{0};
+
+    bool accepts(const Config &c) const { return count == 0 || (count < maxVoices && config == c); }
+    // Resets the lanes for a free slot and points v.group and v.groupSlot at them
+    void join(PolysynthVoice &v, const Config &c);
+    void leave(PolysynthVoice &v);
+
+    // Per sample, four lanes each. load and unload move one voice's slot in and out.
+    float in alignas(16)[blockSizeOS][4]{}, out alignas(16)[blockSizeOS][4]{};
+    float drive alignas(16)[blockSizeOS][4]{}, bias alignas(16)[blockSizeOS][4]{};
+    float feedback alignas(16)[blockSizeOS][4]{};
+    void load(PolysynthVoice &v);
+    void unload(PolysynthVoice &v);
+
+    void process() { kernel(*this); }
+
+    sst::filters::FilterUnitQFPtr qfPtr{nullptr};
+    sst::filters::QuadFilterUnitState qfState{};
+    sst::waveshapers::QuadWaveshaperPtr wsPtr{nullptr};
+    sst::waveshapers::QuadWaveshaperState wsState{};
+    SVF svf;
+    __m128 feedbackSignal{_mm_setzero_ps()};
+
+    float delayBufferData[4][sst::filters::utilities::MAX_FB_COMB +
+                             sst::filters::utilities::SincTable::FIRipol_N]{};
+
+  private:
+    using Kernel = void (*)(VoiceGroup &);
+    Kernel kernel{nullptr};
+
+    static constexpr int svfOff{-1};
+    static Kernel kernelFor(const Config &c);
+    template <int Routing> static Kernel kernelForRouting(const Config &c);
+    template <int Routing, int SVFMode> static Kernel kernelForStages(const Config &c);
+    template <int Routing, int SVFMode, bool LPF, bool WS> static void processKernel(VoiceGroup &g);
+};
+} // namespace sst::conduit::polysynth
+#endif
@@ -20,6 +20,7 @@
  */
 
 #include "voice.h"
+#include "voice-group.h"
 #include "polysynth.h"
 #include <cmath>
 #include <algorithm>
@@ -40,6 +41,8 @@ float pival =
 
 void PolysynthVoice::recalcPitch()
 {
+    // An MTS-ESP master can retune a held note at any time and doesn't say when, so the
+    // lookup runs every block and its result is part of the key below
     if (mtsClient && MTS_HasMaster(mtsClient))
     {
         baseFreq = MTS_NoteToFrequency(mtsClient, key, channel);
@@ -51,18 +54,63 @@ void PolysynthVoice::recalcPitch()
 
     auto coarseBend =
         pitchNoteExpressionValue + pitchBendWheel + mpePitchBend * 24; // hardocde range for now
+
+    PitchInputs pi;
+    pi.tunedFreq = baseFreq;
+    pi.bend = coarseBend;
     if (sawActive)
     {
-        for (int i = 0; i < sawUnison; ++i)
+        pi.sawDetune = sawUnisonDetune.value();
+        pi.sawCoarse = sawCoarse.value();
+        pi.sawFine = sawFine.value();
+    }
+    if (pulseActive)
+    {
+        pi.pulseOctave = pulseOctave.value();
+        pi.pulseCoarse = pulseCoarse.value();
+        pi.pulseFine = pulseFine.value();
+        pi.pulseWidth = pulseWidth.value();
+    }
+    if (sinActive)
+    {
+        pi.sinOctave = sinOctave.value();
+        pi.sinCoarse = sinCoarse.value();
+    }
+
+    if (pitchInputsValid && pi == pitchInputs)
+    {
+        // The pulse glides over a block towards each target it is given and keeps stepping
+        // unless told otherwise, so it gets its target once more the block after a change;
+        // after that its step is zero. The saw bank and the sine hold their own.
+        if (pulseActive && !pulsePinned)
+        {
+            pulseOsc.setFrequency(pulseFrequency, srInv);
+            pulseOsc.setPulseWidth(pulseWidth.value());
+            pulsePinned = true;
+        }
+        return;
+    }
+    pitchInputs = pi;
+    pitchInputsValid = true;
+
+    if (sawActive)
+    {
+        auto spread = sawUnisonDetune.value();
+        if (!sawUniRatioValid || spread != sawUniRatioSpread)
         {
-            auto uf =
-                baseFreq *
-                synth.twoToXTable.twoToThe(
-                    ((sawUnisonDetune.value() * sawUniVoiceDetune[i] + sawFine.value()) / 100 +
-                     sawCoarse.value() + coarseBend) /
-                    12.0);
-            sawOsc[i].setFrequency(uf, srInv);
+            for (int i = 0; i < sawUnison; ++i)
+                sawUniRatio[i] =
+                    synth.twoToXTable.twoToThe(spread * sawUniVoiceDetune[i] / 1200.0);
+            sawUniRatioSpread = spread;
+            sawUniRatioValid = true;
         }
+
+        auto center = baseFreq * synth.twoToXTable.twoToThe(
+                                     (sawFine.value() / 100 + sawCoarse.value() + coarseBend) / 12);
+        float uf[max_uni];
+        for (int i = 0; i < sawUnison; ++i)
+            uf[i] = center * sawUniRatio[i];
+        sawBank.setFrequencies(uf, srInv);
     }
 
     static constexpr float mul[7] = {0.125, 0.25, 0.5, 1, 2, 4, 8};
@@ -71,10 +119,12 @@ void PolysynthVoice::recalcPitch()
     {
         auto po = std::clamp((int)std::round(pulseOctave.value()) + 3, 0, 6);
         auto sbf = baseFreq * mul[po];
-        auto pf = sbf * synth.twoToXTable.twoToThe(
-                            (pulseCoarse.value() + pulseFine.value() * 0.01 + coarseBend) / 12.0);
-        pulseOsc.setFrequency(pf, srInv);
+        pulseFrequency =
+            sbf * synth.twoToXTable.twoToThe(
+                      (pulseCoarse.value() + pulseFine.value() * 0.01 + coarseBend) / 12.0);
+        pulseOsc.setFrequency(pulseFrequency, srInv);
         pulseOsc.setPulseWidth(pulseWidth.value());
+        pulsePinned = false;
     }
 
     if (sinActive)
@@ -88,11 +138,16 @@ void PolysynthVoice::recalcPitch()
 
 void PolysynthVoice::recalcFilter()
 {
+    // The coefficients live in our lanes of the group, so there is nothing to do until we join
+    if (!group)
+        return;
+
+    auto lane = groupSlot * 2;
     if (svfActive)
     {
         auto co = svfCutoff.value();
         auto rm = svfResonance.value();
-        svfImpl.setCoeff(co, rm, srInv);
+        group->svf.setCoeff(co, rm, srInv, lane, 2);
     }
 
     if (lpfActive)
@@ -101,52 +156,14 @@ void PolysynthVoice::recalcFilter()
         coefMaker.setSampleRateAndBlockSize(samplerate, blockSize);
         coefMaker.MakeCoeffs(lpfCutoff.value() - 60, lpfResonance.value(), qfType, qfSubType,
                              nullptr, false);
-        coefMaker.updateState(qfState);
+        coefMaker.updateState(group->qfState, lane);
+        coefMaker.updateState(group->qfState, lane + 1);
     }
 }
 
-static __m128 wsNoOp(sst::waveshapers::QuadWaveshaperState *__restrict, __m128 in, __m128 drive)
-{
-    return in;
-}
-
-static __m128 qfNoOp(sst::filters::QuadFilterUnitState *__restrict, __m128 in) { return in; }
-
-void PolysynthVoice::processBlock()
+void PolysynthVoice::renderSourcesKernel()
 {
     static constexpr float vScale{0.2};
-    aeg.processBlock(aegValues.attack.value(), aegValues.decay.value(), aegValues.sustain.value(),
-                     aegValues.release.value(), 0, 0, 0, gated);
-    feg.processBlock(fegValues.attack.value(), fegValues.decay.value(), fegValues.sustain.value(),
-                     fegValues.release.value(), 0, 0, 0, gated);
-    lfos[0].process_block(lfoData[0].rate.value(), lfoData[0].deform.value(), lfoData[0].shape);
-    lfos[1].process_block(lfoData[1].rate.value(), lfoData[1].deform.value(), lfoData[1].shape);
-
-    *svfCutoff.internalMod = 0;
-    *lpfCutoff.internalMod = 0;
-
-    for (auto &r : routings)
-    {
-        if (r.target)
-            *(r.target) = 0;
-    }
-    for (auto &r : routings)
-    {
-        if (r.source && r.target)
-        {
-            auto s = *(r.source);
-            s *= (r.via ? *(r.via) : 1);
-            *(r.target) += s * (*r.depth) * r.range;
-        }
-    }
-
-    *svfCutoff.internalMod +=
-        feg.outBlock0 * fegToSvfCutoff.value() + svfKeytrack.value() * (key - 69);
-    *lpfCutoff.internalMod +=
-        feg.outBlock0 * fegToLPFCutoff.value() + lpfKeytrack.value() * (key - 69);
-
-    recalcFilter();
-    recalcPitch();
 
     memset(outputOS, 0, sizeof(outputOS));
 
@@ -155,18 +172,13 @@ void PolysynthVoice::processBlock()
         sawLevel_lipol.newValue(sawLevel.value());
         for (auto s = 0U; s < blockSizeOS; ++s)
         {
-            float L{0}, R{0};
+            float L, R;
+            sawBank.step(L, R);
             auto sl = sawLevel_lipol.v;
-            sl = sl * sl * sl;
-            for (int i = 0; i < sawUnison; ++i)
-            {
-                auto out = sawOsc[i].step();
-                L += vScale * sl * sawUniLevelNorm[i] * sawUniPanL[i] * out;
-                R += vScale * sl * sawUniLevelNorm[i] * sawUniPanR[i] * out;
-            }
-
-            outputOS[0][s] += L;
-            outputOS[1][s] += R;
+            sl = vScale * sl * sl * sl;
+
+            outputOS[0][s] += sl * L;
+            outputOS[1][s] += sl * R;
             sawLevel_lipol.process();
         }
     }
@@ -219,6 +231,53 @@ void PolysynthVoice::processBlock()
             noiseLevel_lipol.process();
         }
     }
+}
+
+CONDUIT_TARGET_AVX2 void PolysynthVoice::renderSourcesAVX2() { renderSourcesKernel(); }
+
+void PolysynthVoice::renderSources()
+{
+    if (shared::cpu::useAVX2())
+        return renderSourcesAVX2();
+    renderSourcesKernel();
+}
+
+void PolysynthVoice::processBlock()
+{
+    aeg.processBlock(aegValues.attack.value(), aegValues.decay.value(), aegValues.sustain.value(),
+                     aegValues.release.value(), 0, 0, 0, gated);
+    feg.processBlock(fegValues.attack.value(), fegValues.decay.value(), fegValues.sustain.value(),
+                     fegValues.release.value(), 0, 0, 0, gated);
+    lfos[0].process_block(lfoData[0].rate.value(), lfoData[0].deform.value(), lfoData[0].shape);
+    lfos[1].process_block(lfoData[1].rate.value(), lfoData[1].deform.value(), lfoData[1].shape);
+
+    *svfCutoff.internalMod = 0;
+    *lpfCutoff.internalMod = 0;
+
+    for (auto &r : routings)
+    {
+        if (r.target)
+            *(r.target) = 0;
+    }
+    for (auto &r : routings)
+    {
+        if (r.source && r.target)
+        {
+            auto s = *(r.source);
+            s *= (r.via ? *(r.via) : 1);
+            *(r.target) += s * (*r.depth) * r.range;
+        }
+    }
+
+    *svfCutoff.internalMod +=
+        feg.outBlock0 * fegToSvfCutoff.value() + svfKeytrack.value() * (key - 69);
+    *lpfCutoff.internalMod +=
+        feg.outBlock0 * fegToLPFCutoff.value() + lpfKeytrack.value() * (key - 69);
+
+    recalcFilter();
+    recalcPitch();
+
+    renderSources();
 
     // Filter stage
     aegPFG_lipol.set_target(synth.dbToLinear(aegPFG.value()));
@@ -227,96 +286,15 @@ void PolysynthVoice::processBlock()
     wsDrive_lipol.newValue(synth.dbToLinear(wsDrive.value()));
     wsBias_lipol.newValue(wsBias.value() * (wsActive ? 1.f : 0.f));
     filterFeedback_lipol.newValue(filterFeedback.value());
-    if (anyFilterStepActive)
-    {
+    if (group)
+        group->load(*this);
+}
+
+void PolysynthVoice::finishBlock()
+{
+    if (group)
+        group->unload(*this);
 
-#define PACK                                                                                       \
-    auto output = _mm_set_ps(0, 0, outputOS[1][s], outputOS[0][s]);                                \
-    auto drive = _mm_set1_ps(wsDrive_lipol.v);                                                     \
-    wsDrive_lipol.process();                                                                       \
-    auto bias = _mm_set1_ps(wsBias_lipol.v);                                                       \
-    wsBias_lipol.process();                                                                        \
-    auto fback = _mm_set1_ps(filterFeedback_lipol.v);                                              \
-    filterFeedback_lipol.process();                                                                \
-    output = _mm_add_ps(output, filterFeedbackSignal)
-
-#define UNPACK                                                                                     \
-    filterFeedbackSignal = _mm_mul_ps(output, fback);                                              \
-    float outArr alignas(16)[4];                                                                   \
-    _mm_store_ps(outArr, output);                                                                  \
-    outputOS[0][s] = outArr[0];                                                                    \
-    outputOS[1][s] = outArr[1]
-
-        switch (filterRouting)
-        {
-        case LowWSMulti:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = qfPtr(&qfState, output);
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                output = svfFilterOp(svfImpl, output);
-                UNPACK;
-            }
-            break;
-        case MultiWSLow:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = svfFilterOp(svfImpl, output);
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                output = qfPtr(&qfState, output);
-                UNPACK;
-            }
-            break;
-        case WSLowMulti:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                output = qfPtr(&qfState, output);
-                output = svfFilterOp(svfImpl, output);
-                UNPACK;
-            }
-            break;
-        case LowMultiWS:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = qfPtr(&qfState, output);
-                output = svfFilterOp(svfImpl, output);
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-                UNPACK;
-            }
-            break;
-        case WSPar:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-
-                auto outputQ = qfPtr(&qfState, output);
-                auto outputS = svfFilterOp(svfImpl, output);
-                const auto half = _mm_set1_ps(0.5f);
-                output = _mm_mul_ps(half, _mm_add_ps(outputQ, outputS));
-                UNPACK;
-            }
-            break;
-        case ParWS:
-            for (auto s = 0U; s < blockSizeOS; ++s)
-            {
-                PACK;
-                auto outputQ = qfPtr(&qfState, output);
-                auto outputS = svfFilterOp(svfImpl, output);
-                const auto half = _mm_set1_ps(0.5f);
-                output = _mm_mul_ps(half, _mm_add_ps(outputQ, outputS));
-                output = wsPtr(&wsState, _mm_add_ps(output, bias), drive);
-
-                UNPACK;
-            }
-            break;
-        }
-    }
     sst::basic_blocks::mechanics::scale_by<blockSizeOS>(aeg.outputCache, outputOS[0]);
     sst::basic_blocks::mechanics::scale_by<blockSizeOS>(aeg.outputCache, outputOS[1]);
 
@@ -357,87 +335,56 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
 
     pitchBendWheel = 0;
     mpePitchBend = 0;
-    filterFeedbackSignal = _mm_setzero_ps();
 
-    sawUnison = static_cast<int>(*synth.paramToValue.at(ConduitPolysynth::pmSawUnisonCount));
+    const auto &ap = synth.audioParams;
+    sawUnison = std::clamp(static_cast<int>(synth.paramValue(ap.sawUnisonCount)), 1, max_uni);
 
-    sawActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmSawActive));
-    pulseActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmPWActive));
-    sinActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmSinActive));
-    noiseActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmNoiseActive));
+    sawActive = static_cast<bool>(synth.paramValue(ap.sawActive));
+    pulseActive = static_cast<bool>(synth.paramValue(ap.pulseActive));
+    sinActive = static_cast<bool>(synth.paramValue(ap.sinActive));
+    noiseActive = static_cast<bool>(synth.paramValue(ap.noiseActive));
 
-    svfActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmSVFActive));
+    svfActive = static_cast<bool>(synth.paramValue(ap.svfActive));
     if (svfActive)
-    {
-        svfMode = static_cast<int>(*synth.paramToValue.at(ConduitPolysynth::pmSVFFilterMode));
-        switch (svfMode)
-        {
-        case StereoSimperSVF::LP:
-            svfFilterOp = StereoSimperSVF::stepSSE<StereoSimperSVF::LP>;
-            break;
-        case StereoSimperSVF::HP:
-            svfFilterOp = StereoSimperSVF::stepSSE<StereoSimperSVF::HP>;
-            break;
-        case StereoSimperSVF::BP:
-            svfFilterOp = StereoSimperSVF::stepSSE<StereoSimperSVF::BP>;
-            break;
-        case StereoSimperSVF::NOTCH:
-            svfFilterOp = StereoSimperSVF::stepSSE<StereoSimperSVF::NOTCH>;
-            break;
-        case StereoSimperSVF::PEAK:
-            svfFilterOp = StereoSimperSVF::stepSSE<StereoSimperSVF::PEAK>;
-            break;
-        case StereoSimperSVF::ALL:
-            svfFilterOp = StereoSimperSVF::stepSSE<StereoSimperSVF::ALL>;
-            break;
-        }
-    }
-    else
-    {
-        svfFilterOp = [](auto &a, auto b) { return b; };
-    }
+        svfMode = static_cast<int>(synth.paramValue(ap.svfMode));
 
     gated = true;
     active = true;
     srInv = 1.0 / samplerate;
 
-    svfImpl.init();
-
     aeg.attackFrom(0.f, aegValues.attack.value(), 0, false);
     feg.attackFrom(0.f, fegValues.attack.value(), 0, false);
+    float sawUniPanL[max_uni], sawUniPanR[max_uni];
     if (sawUnison == 1)
     {
         sawUniVoiceDetune[0] = 0;
         sawUniPanL[0] = 1;
         sawUniPanR[0] = 1;
-        sawUniLevelNorm[0] = 1.0;
     }
     else
     {
+        auto levelNorm = 1.0 / sqrt(sawUnison);
         for (int i = 0; i < sawUnison; ++i)
         {
             float dI = 1.0 * i / (sawUnison - 1);
             sawUniVoiceDetune[i] = 2 * dI - 1;
-            sawUniPanL[i] = std::cos(0.5 * pival * dI);
-            sawUniPanR[i] = std::sin(0.5 * pival * dI);
-
-            sawUniLevelNorm[i] = 1.0 / sqrt(sawUnison);
+            sawUniPanL[i] = levelNorm * std::cos(0.5 * pival * dI);
+            sawUniPanR[i] = levelNorm * std::sin(0.5 * pival * dI);
         }
     }
 
-    for (auto &o : sawOsc)
-        o.retrigger();
+    sawBank.retrigger(sawUnison);
+    sawBank.setGains(sawUniPanL, sawUniPanR);
+    sawUniRatioValid = false;
 
+    pitchInputsValid = false;
     recalcPitch();
-    recalcFilter();
 
-    wsActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmWSActive));
+    wsActive = static_cast<bool>(synth.paramValue(ap.wsActive));
 
     if (wsActive)
     {
-        float R[sst::waveshapers::n_waveshaper_registers];
-        auto wsTypeEnum =
-            static_cast<Waveshapers>(*synth.paramToValue.at(ConduitPolysynth::pmWSMode));
+        auto wsTypeEnum = static_cast<Waveshapers>(synth.paramValue(ap.wsMode));
 
         auto type = sst::waveshapers::WaveshaperType::wst_ojd;
         switch (wsTypeEnum)
@@ -461,35 +408,14 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
             type = sst::waveshapers::WaveshaperType::wst_fuzz;
             break;
         }
-        sst::waveshapers::initializeWaveshaperRegister(type, R);
-
-        for (int i = 0; i < sst::waveshapers::n_waveshaper_registers; ++i)
-        {
-            wsState.R[i] = _mm_set1_ps(R[i]);
-        }
-        wsState.init = _mm_cmpneq_ps(_mm_setzero_ps(), _mm_setzero_ps());
-        wsPtr = sst::waveshapers::GetQuadWaveshaper(type);
-    }
-    else
-    {
-        wsPtr = wsNoOp;
+        wsType = type;
     }
 
-    lpfActive = static_cast<bool>(*synth.paramToValue.at(ConduitPolysynth::pmLPFActive));
+    lpfActive = static_cast<bool>(synth.paramValue(ap.lpfActive));
 
     if (lpfActive)
     {
-        qfState = sst::filters::QuadFilterUnitState{};
-        for (int i = 0; i < 4; ++i)
-        {
-            memset(delayBufferData[i], 0, sizeof(delayBufferData[i]));
-            qfState.DB[i] = delayBufferData[i];
-            qfState.active[i] = (int)0xffffffff;
-            qfState.WP[i] = 0;
-        }
-
-        auto lpfTypeEnum =
-            static_cast<LPFTypes>(*synth.paramToValue.at(ConduitPolysynth::pmLPFFilterMode));
+        auto lpfTypeEnum = static_cast<LPFTypes>(synth.paramValue(ap.lpfMode));
 
         switch (lpfTypeEnum)
         {
@@ -518,27 +444,19 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
             qfSubType = sst::filters::FilterSubType::st_resonancewarp_tanh4;
             break;
         }
-
-        qfPtr = sst::filters::GetCompensatedQFPtrFilterUnit<true>(qfType, qfSubType);
-    }
-    else
-    {
-        qfPtr = qfNoOp;
     }
 
-    filterRouting =
-        static_cast<FilterRouting>(*synth.paramToValue.at(ConduitPolysynth::pmFilterRouting));
+    filterRouting = static_cast<FilterRouting>(synth.paramValue(ap.filterRouting));
 
     anyFilterStepActive = wsActive || svfActive || lpfActive;
 
-    auto l1shp = static_cast<int>(*synth.paramToValue.at(ConduitPolysynth::pmLFOShape));
+    auto l1shp = static_cast<int>(synth.paramValue(ap.lfoShape[0]));
     if (l1shp > 1)
         l1shp++;
     lfoData[0].shape = (lfo_t::Shape)l1shp;
     lfos[0].attack(lfoData[0].shape);
 
-    auto l2shp = static_cast<int>(
-        *synth.paramToValue.at(ConduitPolysynth::pmLFOShape + ConduitPolysynth::offPmLFO2));
+    auto l2shp = static_cast<int>(synth.paramValue(ap.lfoShape[1]));
     if (l2shp > 1)
         l2shp++;
     lfoData[1].shape = (lfo_t::Shape)l2shp;
@@ -558,9 +476,11 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
 
         if (r.source != ModMatrixConfig::NONE && r.target != ConduitPolysynth::pmNoModTarget)
         {
-            auto pmd = synth.paramDescriptionMap.at(r.target);
-            rt.range = pmd.maxVal - pmd.minVal;
-            auto tp = internalMods.find(r.target);
+            auto pmd = synth.paramDescription(r.target);
+            assert(pmd);
+            rt.range = pmd ? pmd->maxVal - pmd->minVal : 0.f;
+            auto slot = synth.paramSlot(r.target);
+            assert(slot >= 0);
 
             auto assignMod = [this](const auto &basedOn, auto &to) {
                 switch (basedOn)
@@ -613,7 +533,7 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
             rt.via = nullptr;
             assignMod(r.source, rt.source);
             assignMod(r.via, rt.via);
-            rt.target = &(tp->second);
+            rt.target = &(internalMods[std::max(slot, 0)]);
             rt.depth = &(r.depth);
         }
         idx++;
@@ -623,12 +543,18 @@ void PolysynthVoice::start(int16_t porti, int16_t channeli, int16_t keyi, int32_
 void PolysynthVoice::release() { gated = false; }
 
 void PolysynthVoice::StereoSimperSVF::setCoeff(float key, float res, float srInv)
+{
+    setCoeff(key, res, srInv, 0, 4);
+}
+
+void PolysynthVoice::StereoSimperSVF::setCoeff(float key, float res, float srInv, int firstLane,
+                                               int count)
 {
     auto co = 440.0 * pow(2.0, (key - 69.0) / 12);
     co = std::clamp(co, 10.0, 25000.0); // just to be safe/lazy
     res = std::clamp(res, 0.01f, 0.99f);
-    g = _mm_set1_ps(sst::basic_blocks::dsp::fasttan(pival * co * srInv));
-    k = _mm_set1_ps(2.0 - 2.0 * res);
+    setLanes(g, firstLane, count, sst::basic_blocks::dsp::fasttan(pival * co * srInv));
+    setLanes(k, firstLane, count, 2.0 - 2.0 * res);
     gk = _mm_add_ps(g, k);
     a1 = _mm_div_ps(oneSSE, _mm_add_ps(oneSSE, _mm_mul_ps(g, gk)));
     a2 = _mm_mul_ps(g, a1);
@@ -647,54 +573,6 @@ void PolysynthVoice::StereoSimperSVF::step(StereoSimperSVF &that, float &L, floa
     R = r4[1];
 }
 
-template <int FilterMode>
-__m128 PolysynthVoice::StereoSimperSVF::stepSSE(StereoSimperSVF &that, __m128 vin)
-{
-    // auto v3 = vin[c] - ic2eq[c];
-    auto v3 = _mm_sub_ps(vin, that.ic2eq);
-    // auto v0 = a1 * v3 - ak * ic1eq[c];
-    auto v0 = _mm_sub_ps(_mm_mul_ps(that.a1, v3), _mm_mul_ps(that.ak, that.ic1eq));
-    // auto v1 = a2 * v3 + a1 * ic1eq[c];
-    auto v1 = _mm_add_ps(_mm_mul_ps(that.a2, v3), _mm_mul_ps(that.a1, that.ic1eq));
-
-    // auto v2 = a3 * v3 + a2 * ic1eq[c] + ic2eq[c];
-    auto v2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(that.a3, v3), _mm_mul_ps(that.a2, that.ic1eq)),
-                         that.ic2eq);
-
-    // ic1eq[c] = 2 * v1 - ic1eq[c];
-    that.ic1eq = _mm_sub_ps(_mm_mul_ps(that.twoSSE, v1), that.ic1eq);
-    // ic2eq[c] = 2 * v2 - ic2eq[c];
-    that.ic2eq = _mm_sub_ps(_mm_mul_ps(that.twoSSE, v2), that.ic2eq);
-
-    __m128 res;
-
-    switch (FilterMode)
-    {
-    case LP:
-        res = v2;
-        break;
-    case BP:
-        res = v1;
-        break;
-    case HP:
-        res = v0;
-        break;
-    case NOTCH:
-        res = _mm_add_ps(v2, v0);
-        break;
-    case PEAK:
-        res = _mm_sub_ps(v2, v0);
-        break;
-    case ALL:
-        res = _mm_sub_ps(_mm_add_ps(v2, v0), _mm_mul_ps(that.k, v1));
-        break;
-    default:
-        res = _mm_setzero_ps();
-    }
-
-    return res;
-}
-
 void PolysynthVoice::StereoSimperSVF::init()
 {
     ic1eq = _mm_setzero_ps();
@@ -705,10 +583,10 @@ void PolysynthVoice::attachTo(sst::conduit::polysynth::ConduitPolysynth &p)
 {
     auto attach = [this, &p](clap_id parm, ModulatedValue &toThat) {
         p.attachParam(parm, toThat.base);
-        externalMods[parm] = 0;
-        internalMods[parm] = 0;
-        toThat.internalMod = &(internalMods[parm]);
-        toThat.externalMod = &(externalMods[parm]);
+        auto slot = p.paramSlot(parm);
+        assert(slot >= 0);
+        toThat.internalMod = &(internalMods[slot]);
+        toThat.externalMod = &(externalMods[slot]);
     };
     attach(ConduitPolysynth::pmSawUnisonSpread, sawUnisonDetune);
     attach(ConduitPolysynth::pmSawCoarse, sawCoarse);
@@ -768,16 +646,14 @@ void PolysynthVoice::attachTo(sst::conduit::polysynth::ConduitPolysynth &p)
     attach(ConduitPolysynth::pmLFOAmplitude + ConduitPolysynth::offPmLFO2, lfoData[1].amplitude);
 
     attach(ConduitPolysynth::pmAegVelocitySens, velocitySens);
-
-    mtsClient = p.mtsClient;
 }
 
 void PolysynthVoice::applyExternalMod(clap_id param, float value)
 {
-    auto emit = externalMods.find(param);
-    if (emit != externalMods.end())
+    auto slot = synth.paramSlot(param);
+    if (slot >= 0)
     {
-        emit->second = value;
+        externalMods[slot] = value;
     }
 }
 
@@ -801,7 +677,7 @@ void PolysynthVoice::receiveNoteExpression(int expression, double value)
         mpePressure = value;
     }
     default:
-        CNDOUT << "Un-handled note expression " << expression << std::endl;
+        CNDRTLOG("Un-handled note expression {}", expression);
     }
 }
 
@@ -24,13 +24,13 @@
 
 #include <array>
 #include <random>
-#include <unordered_map>
-#include <functional>
 
 #include <clap/clap.h>
 
+#include "conduit-shared/cpu-dispatch.h"
 #include "conduit-shared/debug-helpers.h"
 #include "conduit-shared/sse-include.h"
+#include "conduit-shared/shared-tables.h"
 
 #include "sst/basic-blocks/dsp/DPWSawPulseOscillator.h"
 #include "sst/basic-blocks/dsp/QuadratureOscillators.h"
@@ -41,16 +41,31 @@
 #include "sst/filters.h"
 #include "sst/waveshapers.h"
 
+#include "unison-saw-bank.h"
+
 struct MTSClient;
 
 namespace sst::conduit::polysynth
 {
+// The synth's param count, here so voices can size their per param modulation arrays
+static constexpr int nParams{72};
 
 struct ConduitPolysynth;
+struct VoiceGroup;
+
+// Writes v into lanes [first, first + count) of r, leaving the other lanes alone
+inline void setLanes(__m128 &r, int first, int count, float v)
+{
+    float lanes alignas(16)[4];
+    _mm_store_ps(lanes, r);
+    for (int i = first; i < first + count; ++i)
+        lanes[i] = v;
+    r = _mm_load_ps(lanes);
+}
 
 struct PolysynthVoice
 {
-    static constexpr int max_uni{7};
+    static constexpr int max_uni{16};
     static constexpr int blockSize{8};
     static constexpr int blockSizeOS{blockSize << 1};
 
@@ -58,10 +73,6 @@ struct PolysynthVoice
     PolysynthVoice(const ConduitPolysynth &sy)
         : synth(sy), gen((uint64_t)(this)), urd(-1.0, 1.0), aeg(this), feg(this), lfos{this, this}
     {
-        for (int i = 0; i < 128; ++i)
-        {
-            baseFrequencyByMidiKey[i] = 440.0 * pow(2.0, (i - 69.0) / 12.0);
-        }
     }
 
     void setSampleRate(double sr)
@@ -132,7 +143,8 @@ struct PolysynthVoice
         Comb
     };
 
-    std::unordered_map<clap_id, float> externalMods, internalMods;
+    // Indexed by param slot; only the params attachTo wires up are ever non-zero
+    float externalMods[nParams]{}, internalMods[nParams]{};
 
     void applyExternalMod(clap_id param, float value);
 
@@ -141,11 +153,13 @@ struct PolysynthVoice
     bool sawActive{true};
     ModulatedValue sawUnisonDetune, sawCoarse, sawFine, sawLevel;
     sst::basic_blocks::dsp::lipol<float, blockSizeOS, true> sawLevel_lipol;
-    std::array<float, max_uni> sawUniPanL, sawUniPanR, sawUniVoiceDetune, sawUniLevelNorm;
-    std::array<sst::basic_blocks::dsp::DPWSawOscillator<
-                   sst::basic_blocks::dsp::BlockInterpSmoothingStrategy<blockSize>>,
-               max_uni>
-        sawOsc;
+    std::array<float, max_uni> sawUniVoiceDetune;
+    // Glides over blockSize steps, as the BlockInterpSmoothingStrategy saws it replaced did
+    UnisonSawBank<max_uni, blockSize> sawBank;
+    // The per voice detune ratios only move with the spread, so recalcPitch caches them
+    std::array<float, max_uni> sawUniRatio;
+    float sawUniRatioSpread{0.f};
+    bool sawUniRatioValid{false};
 
     // Pulse Oscillator
     bool pulseActive{true};
@@ -197,7 +211,6 @@ struct PolysynthVoice
 
     sst::basic_blocks::dsp::lipol<float, blockSizeOS, true> filterFeedback_lipol;
     ModulatedValue filterFeedback;
-    __m128 filterFeedbackSignal;
 
     bool anyFilterStepActive;
 
@@ -229,15 +242,47 @@ struct PolysynthVoice
         ModulatedValue rate, deform, amplitude;
     } lfoData[2];
 
+    /*
+     * Rendering is split around the filter stage, which runs in a VoiceGroup. processBlock
+     * renders the sources into outputOS and hands them to the group; once the synth has
+     * processed the groups, finishBlock takes the filtered signal back and applies the
+     * amp envelope, level and pan. Voices with every filter stage off have no group.
+     */
     void processBlock();
+    void finishBlock();
+    // The oscillator and noise loops into outputOS, in a variant picked as cpu-dispatch.h shows
+    void renderSources();
+    CONDUIT_TARGET_AVX2 void renderSourcesAVX2();
+    CONDUIT_FORCE_INLINE void renderSourcesKernel();
+    VoiceGroup *group{nullptr};
+    int groupSlot{-1};
 
     float outputOS alignas(16)[2][blockSizeOS];
 
     void start(int16_t port, int16_t channel, int16_t key, int32_t noteid, double velocity);
     void release();
 
-    float baseFrequencyByMidiKey[128];
+    const float *baseFrequencyByMidiKey{shared::tables::midiKeyFrequencies().hz};
     void recalcPitch();
+
+    // Everything recalcPitch reads which can move while a voice sounds. Values for
+    // inactive oscillators stay zero, so modulating them doesn't force a recalc.
+    struct PitchInputs
+    {
+        // MTS_NoteToFrequency while a tuning source is connected, else the key's table entry
+        double tunedFreq{0};
+        float bend{0};
+        float sawDetune{0}, sawCoarse{0}, sawFine{0};
+        float pulseOctave{0}, pulseCoarse{0}, pulseFine{0}, pulseWidth{0};
+        float sinOctave{0}, sinCoarse{0};
+
+        bool operator==(const PitchInputs &) const = default;
+    };
+    PitchInputs pitchInputs;
+    bool pitchInputsValid{false};
+    float pulseFrequency{0};
+    bool pulsePinned{false};
+
     void recalcFilter();
 
     void receiveNoteExpression(int expression, double value);
@@ -263,7 +308,7 @@ struct PolysynthVoice
     struct StereoSimperSVF // thanks to urs @ u-he and andy simper @ cytomic
     {
         __m128 ic1eq{_mm_setzero_ps()}, ic2eq{_mm_setzero_ps()};
-        __m128 g, k, gk, a1, a2, a3, ak;
+        __m128 g{_mm_setzero_ps()}, k{_mm_setzero_ps()}, gk, a1, a2, a3, ak;
 
         __m128 oneSSE{_mm_set1_ps(1.0)};
         __m128 twoSSE{_mm_set1_ps(2.0)};
@@ -278,25 +323,19 @@ struct PolysynthVoice
         };
 
         void setCoeff(float key, float res, float srInv);
+        // Only lanes [firstLane, firstLane + count) take the new cutoff and resonance
+        void setCoeff(float key, float res, float srInv, int firstLane, int count);
 
         template <int Mode> static void step(StereoSimperSVF &that, float &L, float &R);
         template <int Mode> static __m128 stepSSE(StereoSimperSVF &that, __m128);
 
         void init();
-    } svfImpl;
-    std::function<__m128(StereoSimperSVF &, __m128)> svfFilterOp;
-
-    sst::waveshapers::QuadWaveshaperPtr wsPtr{nullptr};
-    sst::waveshapers::QuadWaveshaperState wsState;
+    };
 
-    sst::filters::FilterUnitQFPtr qfPtr{nullptr};
-    sst::filters::QuadFilterUnitState qfState;
+    sst::waveshapers::WaveshaperType wsType;
     sst::filters::FilterType qfType;
     sst::filters::FilterSubType qfSubType;
 
-    float delayBufferData[4][sst::filters::utilities::MAX_FB_COMB +
-                             sst::filters::utilities::SincTable::FIRipol_N]{};
-
     struct ModRoutingData
     {
         float *source{nullptr};
@@ -312,5 +351,54 @@ struct PolysynthVoice
     double baseFreq{440.0};
     double srInv{1.0 / 44100.0};
 };
+
+// In the header so the voice group kernels can inline it
+template <int FilterMode>
+inline __m128 PolysynthVoice::StereoSimperSVF::stepSSE(StereoSimperSVF &that, __m128 vin)
+{
+    // auto v3 = vin[c] - ic2eq[c];
+    auto v3 = _mm_sub_ps(vin, that.ic2eq);
+    // auto v0 = a1 * v3 - ak * ic1eq[c];
+    auto v0 = _mm_sub_ps(_mm_mul_ps(that.a1, v3), _mm_mul_ps(that.ak, that.ic1eq));
+    // auto v1 = a2 * v3 + a1 * ic1eq[c];
+    auto v1 = _mm_add_ps(_mm_mul_ps(that.a2, v3), _mm_mul_ps(that.a1, that.ic1eq));
+
+    // auto v2 = a3 * v3 + a2 * ic1eq[c] + ic2eq[c];
+    auto v2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(that.a3, v3), _mm_mul_ps(that.a2, that.ic1eq)),
+                         that.ic2eq);
+
+    // ic1eq[c] = 2 * v1 - ic1eq[c];
+    that.ic1eq = _mm_sub_ps(_mm_mul_ps(that.twoSSE, v1), that.ic1eq);
+    // ic2eq[c] = 2 * v2 - ic2eq[c];
+    that.ic2eq = _mm_sub_ps(_mm_mul_ps(that.twoSSE, v2), that.ic2eq);
+
+    __m128 res;
+
+    switch (FilterMode)
+    {
+    case LP:
+        res = v2;
+        break;
+    case BP:
+        res = v1;
+        break;
+    case HP:
+        res = v0;
+        break;
+    case NOTCH:
+        res = _mm_add_ps(v2, v0);
+        break;
+    case PEAK:
+        res = _mm_sub_ps(v2, v0);
+        break;
+    case ALL:
+        res = _mm_sub_ps(_mm_add_ps(v2, v0), _mm_mul_ps(that.k, v1));
+        break;
+    default:
+        res = _mm_setzero_ps();
+    }
+
+    return res;
+}
 } // namespace sst::conduit::polysynth
 #endif
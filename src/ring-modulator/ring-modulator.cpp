@@ -99,9 +99,6 @@ ConduitRingModulator::ConduitRingModulator(const clap_host *host)
 
     attachParam(pmAlgo, algo);
     attachParam(pmSource, src);
-
-    clapJuceShim = std::make_unique<sst::clap_juce_shim::ClapJuceShim>(this);
-    clapJuceShim->setResizable(true);
 }
 
 ConduitRingModulator::~ConduitRingModulator() {}
@@ -165,8 +162,74 @@ float diode_sim(float v)
     return h * v - h * vl + h * vlvb * vlvb / (2.f * vl - 2.f * vb);
 }
 
+/*
+ * diode_sim four at a time. The knee is clamped rather than branched on, which is the
+ * same curve: zero below vb, quadratic up to vl, then linear.
+ */
+static CONDUIT_FORCE_INLINE __m128 diodeSimSSE(__m128 v)
+{
+    static constexpr float vb{0.2f}, vl{0.5f}, h{1.f};
+    const auto zero = _mm_setzero_ps();
+    auto knee = _mm_min_ps(_mm_max_ps(_mm_sub_ps(v, _mm_set1_ps(vb)), zero), _mm_set1_ps(vl - vb));
+    auto lin = _mm_max_ps(_mm_sub_ps(v, _mm_set1_ps(vl)), zero);
+    return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(h / (2.f * vl - 2.f * vb)), _mm_mul_ps(knee, knee)),
+                      _mm_mul_ps(_mm_set1_ps(h), lin));
+}
+
+static CONDUIT_FORCE_INLINE void diodeRingModulateKernel(float *__restrict inout,
+                                                         const float *__restrict source, int n)
+{
+    const auto half = _mm_set1_ps(0.5f);
+    const auto signBit = _mm_set1_ps(-0.f);
+    int s{0};
+    for (; s + 4 <= n; s += 4)
+    {
+        auto vin = _mm_mul_ps(half, _mm_loadu_ps(inout + s));
+        auto vc = _mm_loadu_ps(source + s);
+        auto A = _mm_add_ps(vc, vin);
+        auto B = _mm_sub_ps(vc, vin);
+
+        auto dA = _mm_add_ps(diodeSimSSE(A), diodeSimSSE(_mm_xor_ps(A, signBit)));
+        auto dB = _mm_add_ps(diodeSimSSE(B), diodeSimSSE(_mm_xor_ps(B, signBit)));
+        _mm_storeu_ps(inout + s, _mm_sub_ps(dA, dB));
+    }
+
+    for (; s < n; ++s)
+    {
+        auto vin = inout[s];
+        auto vc = source[s];
+        auto A = 0.5 * vin + vc;
+        auto B = vc - 0.5 * vin;
+
+        auto dPA = diode_sim(A);
+        auto dMA = diode_sim(-A);
+        auto dPB = diode_sim(B);
+        auto dMB = diode_sim(-B);
+
+        auto res = dPA + dMA - dPB - dMB;
+
+        inout[s] = res;
+    }
+}
+
+CONDUIT_TARGET_AVX2 static void diodeRingModulateAVX2(float *__restrict inout,
+                                                      const float *__restrict source, int n)
+{
+    diodeRingModulateKernel(inout, source, n);
+}
+
+void diodeRingModulate(float *__restrict inout, const float *__restrict source, int n)
+{
+    if (shared::cpu::useAVX2())
+        return diodeRingModulateAVX2(inout, source, n);
+    diodeRingModulateKernel(inout, source, n);
+}
+
 clap_process_status ConduitRingModulator::process(const clap_process *process) noexcept
 {
+    auto timing = processTimingScope(process);
+    auto trace = traceScope("process");
+
     handleEventsFromUIQueue(process->out_events);
 
     if (process->audio_outputs_count <= 0)
@@ -189,101 +252,107 @@ clap_process_status ConduitRingModulator::process(const clap_process *process) n
     if (chans < 2)
         return CLAP_PROCESS_SLEEP;
 
-    auto ev = process->in_events;
-    auto sz = ev->size(ev);
-
-    // This pointer is the sentinel to our next event which we advance once an event is processed
-    const clap_event_header_t *nextEvent{nullptr};
-    uint32_t nextEventIndex{0};
-    if (sz != 0)
-    {
-        nextEvent = ev->get(ev, nextEventIndex);
-    }
-
     auto isDigital = *algo < 0.5;
-
-    for (auto i = 0U; i < process->frames_count; ++i)
-    {
-        while (nextEvent && nextEvent->time == i)
-        {
-            handleInboundEvent(nextEvent);
-            nextEventIndex++;
-            if (nextEventIndex >= sz)
-                nextEvent = nullptr;
-            else
-                nextEvent = ev->get(ev, nextEventIndex);
-        }
-
-        inputBuf[0][pos] = in[0][i];
-        inputBuf[1][pos] = in[1][i];
-        sidechainBuf[0][pos] = sidechain[0][i];
-        sidechainBuf[1][pos] = sidechain[1][i];
-
-        out[0][i] = outBuf[0][pos] * mix.v + inMixBuf[0][pos] * (1 - mix.v);
-        out[1][i] = outBuf[1][pos] * mix.v + inMixBuf[1][pos] * (1 - mix.v);
-
-        pos++;
-
-        if (pos == blockSize)
-        {
-            memcpy(inMixBuf, inputBuf, sizeof(inMixBuf));
-            hr_up.process_block_U2(inputBuf[0], inputBuf[1], inputOS[0], inputOS[1], blockSizeOS);
-
-            if ((Source)(*src) == srcInternal)
+    auto avx2 = shared::cpu::useAVX2();
+
+    // Lags advance once per internal block (or at an event); see LagBank
+    uint32_t lagOffset{0};
+
+    processInEventChunks(
+        process,
+        [&](auto *evt) {
+            advanceLags(lagOffset);
+            lagOffset = 0;
+            auto ts = traceScope("event");
+            handleInboundEvent(evt);
+        },
+        [&](uint32_t start, uint32_t end) {
+            auto ts = traceScope("render");
+            auto i = start;
+            while (i < end)
             {
-                static constexpr double mf0{8.17579891564};
-                internalSource.setRate(2.0 * M_PI * note_to_pitch_ignoring_tuning(freq.v + 69) *
-                                       mf0 * dsamplerate_inv * 0.5); // 0.5 for oversample
+                auto n = std::min(end - i, (uint32_t)blockSize - pos);
+                for (auto s = 0U; s < n; ++s)
+                {
+                    inputBuf[0][pos + s] = in[0][i + s];
+                    inputBuf[1][pos + s] = in[1][i + s];
+                    sidechainBuf[0][pos + s] = sidechain[0][i + s];
+                    sidechainBuf[1][pos + s] = sidechain[1][i + s];
+                }
 
-                for (int i = 0; i < blockSizeOS; ++i)
+                for (auto s = 0U; s < n; ++s)
                 {
-                    internalSource.step();
-                    sourceOS[0][i] = 2 * internalSource.u;
-                    sourceOS[1][i] = 2 * internalSource.u;
+                    auto mixV = lagValueAt(mix, lagOffset + s);
+                    out[0][i + s] = outBuf[0][pos + s] * mixV + inMixBuf[0][pos + s] * (1 - mixV);
+                    out[1][i + s] = outBuf[1][pos + s] * mixV + inMixBuf[1][pos + s] * (1 - mixV);
                 }
-            }
-            else
-            {
-                hr_scup.process_block_U2(sidechainBuf[0], sidechainBuf[1], sourceOS[0], sourceOS[1],
-                                         blockSizeOS);
-                mech::scale_by<blockSizeOS>(4, sourceOS[0], sourceOS[1]);
-            }
 
-            if (isDigital)
-            {
-                mech::mul_block<blockSizeOS>(inputOS[0], sourceOS[0]);
-                mech::mul_block<blockSizeOS>(inputOS[1], sourceOS[1]);
-            }
-            else
-            {
-                for (int c = 0; c < 2; ++c)
+                i += n;
+                pos += n;
+                lagOffset += n;
+
+                if (pos == blockSize)
                 {
-                    for (int s = 0; s < blockSizeOS; ++s)
-                    {
-                        auto vin = inputOS[c][s];
-                        auto vc = sourceOS[c][s];
-                        auto A = 0.5 * vin + vc;
-                        auto B = vc - 0.5 * vin;
-
-                        auto dPA = diode_sim(A);
-                        auto dMA = diode_sim(-A);
-                        auto dPB = diode_sim(B);
-                        auto dMB = diode_sim(-B);
-
-                        auto res = dPA + dMA - dPB - dMB;
-
-                        inputOS[c][s] = res;
-                    }
+                    auto freqV = lagValueAt(freq, lagOffset);
+                    if (avx2)
+                        processOversampledBlockAVX2(isDigital, freqV);
+                    else
+                        processOversampledBlockKernel(isDigital, freqV);
+                    pos = 0;
+                    advanceLags(lagOffset);
+                    lagOffset = 0;
                 }
             }
+        });
+
+    advanceLags(lagOffset);
+    processPatchSwap(process);
+    return CLAP_PROCESS_CONTINUE;
+}
+
+void ConduitRingModulator::processOversampledBlockKernel(bool isDigital, float freqV)
+{
+    memcpy(inMixBuf, inputBuf, sizeof(inMixBuf));
+    hr_up.process_block_U2(inputBuf[0], inputBuf[1], inputOS[0], inputOS[1], blockSizeOS);
+
+    if ((Source)(*src) == srcInternal)
+    {
+        static constexpr double mf0{8.17579891564};
+        internalSource.setRate(2.0 * M_PI * note_to_pitch_ignoring_tuning(freqV + 69) * mf0 *
+                               dsamplerate_inv * 0.5); // 0.5 for oversample
 
-            hr_down.process_block_D2(inputOS[0], inputOS[1], blockSizeOS, outBuf[0], outBuf[1]);
-            pos = 0;
+        for (int i = 0; i < blockSizeOS; ++i)
+        {
+            internalSource.step();
+            sourceOS[0][i] = 2 * internalSource.u;
+            sourceOS[1][i] = 2 * internalSource.u;
         }
+    }
+    else
+    {
+        hr_scup.process_block_U2(sidechainBuf[0], sidechainBuf[1], sourceOS[0], sourceOS[1],
+                                 blockSizeOS);
+        mech::scale_by<blockSizeOS>(4, sourceOS[0], sourceOS[1]);
+    }
 
-        processLags();
+    if (isDigital)
+    {
+        mech::mul_block<blockSizeOS>(inputOS[0], sourceOS[0]);
+        mech::mul_block<blockSizeOS>(inputOS[1], sourceOS[1]);
     }
-    return CLAP_PROCESS_CONTINUE;
+    else
+    {
+        for (int c = 0; c < 2; ++c)
+            diodeRingModulateKernel(inputOS[c], sourceOS[c], blockSizeOS);
+    }
+
+    hr_down.process_block_D2(inputOS[0], inputOS[1], blockSizeOS, outBuf[0], outBuf[1]);
+}
+
+CONDUIT_TARGET_AVX2 void ConduitRingModulator::processOversampledBlockAVX2(bool isDigital,
+                                                                          float freqV)
+{
+    processOversampledBlockKernel(isDigital, freqV);
 }
 
 void ConduitRingModulator::handleInboundEvent(const clap_event_header_t *evt)
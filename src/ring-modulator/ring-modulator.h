@@ -34,12 +34,17 @@
 #include "sst/filters/HalfRateFilter.h"
 
 #include "conduit-shared/clap-base-class.h"
+#include "conduit-shared/cpu-dispatch.h"
 
 namespace sst::conduit::ring_modulator
 {
 
 static constexpr int nParams = 4;
 
+// The analog mode's diode bridge, one diode and a whole oversampled channel
+float diode_sim(float v);
+void diodeRingModulate(float *__restrict inout, const float *__restrict source, int n);
+
 struct ConduitRingModulatorConfig
 {
     static constexpr int nParams{sst::conduit::ring_modulator::nParams};
@@ -141,9 +146,14 @@ struct ConduitRingModulator
     float outBuf[2][blockSize]{};
     float inMixBuf[2][blockSize]{};
 
+    // Called each time blockSize samples have been collected. process() picks which once
+    // per call; see cpu-dispatch.h
+    CONDUIT_TARGET_AVX2 void processOversampledBlockAVX2(bool isDigital, float freqV);
+    CONDUIT_FORCE_INLINE void processOversampledBlockKernel(bool isDigital, float freqV);
+
     uint32_t pos{0};
 
-    lag_t mix, freq;
+    LagHandle mix, freq;
 
     float *algo, *src;
 };